@@ -11,6 +11,7 @@
 #include <string>
 #include "soa.hpp"
 #include "marketdataservice.hpp"
+#include "latencytracer.hpp"
 
 enum OrderType { FOK, IOC, MARKET, LIMIT, STOP };
 
@@ -218,37 +219,45 @@ public:
 	AlgoExecution(const T& _product, PricingSide _side, string _orderId, OrderType _orderType, double _price, long _visibleQuantity, long _hiddenQuantity, string _parentOrderId, bool _isChildOrder);
 
 	// Get the order
-	ExecutionOrder<T>* GetExecutionOrder() const;
+	ExecutionOrder<T>* GetExecutionOrder();
+	const ExecutionOrder<T>* GetExecutionOrder() const;
 
 private:
-	ExecutionOrder<T>* executionOrder;
+	ExecutionOrder<T> executionOrder;
 
 };
 
 template<typename T>
-AlgoExecution<T>::AlgoExecution(const T& _product, PricingSide _side, string _orderId, OrderType _orderType, double _price, long _visibleQuantity, long _hiddenQuantity, string _parentOrderId, bool _isChildOrder)
+AlgoExecution<T>::AlgoExecution(const T& _product, PricingSide _side, string _orderId, OrderType _orderType, double _price, long _visibleQuantity, long _hiddenQuantity, string _parentOrderId, bool _isChildOrder) :
+	executionOrder(_product, _side, _orderId, _orderType, _price, _visibleQuantity, _hiddenQuantity, _parentOrderId, _isChildOrder)
 {
-	executionOrder = new ExecutionOrder<T>(_product, _side, _orderId, _orderType, _price, _visibleQuantity, _hiddenQuantity, _parentOrderId, _isChildOrder);
 }
 
 template<typename T>
-ExecutionOrder<T>* AlgoExecution<T>::GetExecutionOrder() const
+ExecutionOrder<T>* AlgoExecution<T>::GetExecutionOrder()
 {
-	return executionOrder;
+	return &executionOrder;
+}
+
+template<typename T>
+const ExecutionOrder<T>* AlgoExecution<T>::GetExecutionOrder() const
+{
+	return &executionOrder;
 }
 
 /**
 * Pre-declearations to avoid errors.
 */
-template<typename T>
+template<typename T, size_t N = 5>
 class AlgoExecutionToMarketDataListener;
 
 /**
 * Service for algo executing orders on an exchange.
 * Keyed on product identifier.
 * Type T is the product type.
+* N is the book depth.
 */
-template<typename T>
+template<typename T, size_t N = 5>
 class AlgoExecutionService : public Service<string, AlgoExecution<T>>
 {
 
@@ -256,7 +265,7 @@ private:
 
 	map<string, AlgoExecution<T>> algoExecutions;
 	vector<ServiceListener<AlgoExecution<T>>*> listeners;
-	AlgoExecutionToMarketDataListener<T>* listener;
+	AlgoExecutionToMarketDataListener<T, N>* listener;
 	double spread;
 	long count;
 
@@ -279,58 +288,76 @@ public:
 	const vector<ServiceListener<AlgoExecution<T>>*>& GetListeners() const;
 
 	// Get the listener of the service
-	AlgoExecutionToMarketDataListener<T>* GetListener();
+	AlgoExecutionToMarketDataListener<T, N>* GetListener();
+
+	// Set the widest bid/offer spread the algo crosses
+	void SetSpread(double _spread);
+
+	// Set the signal count, whose parity picks the side of the next order
+	void SetCount(long _count);
 
 	// Execute an order on a market
-	void AlgoExecuteOrder(OrderBook<T>& _orderBook);
+	void AlgoExecuteOrder(const OrderBook<T, N>& _orderBook);
 
 };
 
-template<typename T>
-AlgoExecutionService<T>::AlgoExecutionService()
+template<typename T, size_t N>
+AlgoExecutionService<T, N>::AlgoExecutionService()
 {
 	algoExecutions = map<string, AlgoExecution<T>>();
 	listeners = vector<ServiceListener<AlgoExecution<T>>*>();
-	listener = new AlgoExecutionToMarketDataListener<T>(this);
+	listener = new AlgoExecutionToMarketDataListener<T, N>(this);
 	spread = 1.0 / 128.0;
 	count = 0;
 }
 
-template<typename T>
-AlgoExecutionService<T>::~AlgoExecutionService() {}
+template<typename T, size_t N>
+AlgoExecutionService<T, N>::~AlgoExecutionService() {}
 
-template<typename T>
-AlgoExecution<T>& AlgoExecutionService<T>::GetData(string _key)
+template<typename T, size_t N>
+AlgoExecution<T>& AlgoExecutionService<T, N>::GetData(string _key)
 {
 	return algoExecutions[_key];
 }
 
-template<typename T>
-void AlgoExecutionService<T>::OnMessage(AlgoExecution<T>& _data)
+template<typename T, size_t N>
+void AlgoExecutionService<T, N>::OnMessage(AlgoExecution<T>& _data)
 {
 	algoExecutions[_data.GetExecutionOrder()->GetProduct().GetProductId()] = _data;
 }
 
-template<typename T>
-void AlgoExecutionService<T>::AddListener(ServiceListener<AlgoExecution<T>>* _listener)
+template<typename T, size_t N>
+void AlgoExecutionService<T, N>::AddListener(ServiceListener<AlgoExecution<T>>* _listener)
 {
 	listeners.push_back(_listener);
 }
 
-template<typename T>
-const vector<ServiceListener<AlgoExecution<T>>*>& AlgoExecutionService<T>::GetListeners() const
+template<typename T, size_t N>
+const vector<ServiceListener<AlgoExecution<T>>*>& AlgoExecutionService<T, N>::GetListeners() const
 {
 	return listeners;
 }
 
-template<typename T>
-AlgoExecutionToMarketDataListener<T>* AlgoExecutionService<T>::GetListener()
+template<typename T, size_t N>
+AlgoExecutionToMarketDataListener<T, N>* AlgoExecutionService<T, N>::GetListener()
 {
 	return listener;
 }
 
-template<typename T>
-void AlgoExecutionService<T>::AlgoExecuteOrder(OrderBook<T>& _orderBook)
+template<typename T, size_t N>
+void AlgoExecutionService<T, N>::SetSpread(double _spread)
+{
+	spread = _spread;
+}
+
+template<typename T, size_t N>
+void AlgoExecutionService<T, N>::SetCount(long _count)
+{
+	count = _count;
+}
+
+template<typename T, size_t N>
+void AlgoExecutionService<T, N>::AlgoExecuteOrder(const OrderBook<T, N>& _orderBook)
 {
 	T _product = _orderBook.GetProduct();
 	string _productId = _product.GetProductId();
@@ -357,6 +384,7 @@ void AlgoExecutionService<T>::AlgoExecuteOrder(OrderBook<T>& _orderBook)
 			_side = BID;
 			break;
 		case 1:
+		default:
 			_price = _offerPrice; 
 			_quantity = _offerQuantity;
 			_side = OFFER;
@@ -366,6 +394,7 @@ void AlgoExecutionService<T>::AlgoExecuteOrder(OrderBook<T>& _orderBook)
 		AlgoExecution<T> _algoExecution(_product, _side, _orderId, MARKET, _price, _quantity, 0, "", false);
 		algoExecutions[_productId] = _algoExecution;
 
+		TRACE_STAGE(ORDER_SIGNALLED);
 		for (auto& l : listeners)
 		{
 			l->ProcessAdd(_algoExecution);
@@ -376,51 +405,52 @@ void AlgoExecutionService<T>::AlgoExecuteOrder(OrderBook<T>& _orderBook)
 /**
 * Algo Execution Service Listener subscribing data from Market Data Service to Algo Execution Service.
 * Type T is the product type.
+* N is the book depth.
 */
-template<typename T>
-class AlgoExecutionToMarketDataListener : public ServiceListener<OrderBook<T>>
+template<typename T, size_t N>
+class AlgoExecutionToMarketDataListener : public ServiceListener<OrderBook<T, N>>
 {
 
 private:
 
-	AlgoExecutionService<T>* service;
+	AlgoExecutionService<T, N>* service;
 
 public:
 
 	// Connector and Destructor
-	AlgoExecutionToMarketDataListener(AlgoExecutionService<T>* _service);
+	AlgoExecutionToMarketDataListener(AlgoExecutionService<T, N>* _service);
 	~AlgoExecutionToMarketDataListener();
 
 	// Listener callback to process an add event to the Service
-	void ProcessAdd(OrderBook<T>& _data);
+	void ProcessAdd(OrderBook<T, N>& _data);
 
 	// Listener callback to process a remove event to the Service
-	void ProcessRemove(OrderBook<T>& _data);
+	void ProcessRemove(OrderBook<T, N>& _data);
 
 	// Listener callback to process an update event to the Service
-	void ProcessUpdate(OrderBook<T>& _data);
+	void ProcessUpdate(OrderBook<T, N>& _data);
 
 };
 
-template<typename T>
-AlgoExecutionToMarketDataListener<T>::AlgoExecutionToMarketDataListener(AlgoExecutionService<T>* _service)
+template<typename T, size_t N>
+AlgoExecutionToMarketDataListener<T, N>::AlgoExecutionToMarketDataListener(AlgoExecutionService<T, N>* _service)
 {
 	service = _service;
 }
 
-template<typename T>
-AlgoExecutionToMarketDataListener<T>::~AlgoExecutionToMarketDataListener() {}
+template<typename T, size_t N>
+AlgoExecutionToMarketDataListener<T, N>::~AlgoExecutionToMarketDataListener() {}
 
-template<typename T>
-void AlgoExecutionToMarketDataListener<T>::ProcessAdd(OrderBook<T>& _data)
+template<typename T, size_t N>
+void AlgoExecutionToMarketDataListener<T, N>::ProcessAdd(OrderBook<T, N>& _data)
 {
 	service->AlgoExecuteOrder(_data);
 }
 
-template<typename T>
-void AlgoExecutionToMarketDataListener<T>::ProcessRemove(OrderBook<T>& _data) {}
+template<typename T, size_t N>
+void AlgoExecutionToMarketDataListener<T, N>::ProcessRemove(OrderBook<T, N>& _data) {}
 
-template<typename T>
-void AlgoExecutionToMarketDataListener<T>::ProcessUpdate(OrderBook<T>& _data) {}
+template<typename T, size_t N>
+void AlgoExecutionToMarketDataListener<T, N>::ProcessUpdate(OrderBook<T, N>& _data) {}
 
 #endif
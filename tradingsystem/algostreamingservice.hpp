@@ -185,23 +185,30 @@ public:
 	AlgoStream(const T& _product, const PriceStreamOrder& _bidOrder, const PriceStreamOrder& _offerOrder);
 
 	// Get the order
-	PriceStream<T>* GetPriceStream() const;
+	PriceStream<T>* GetPriceStream();
+	const PriceStream<T>* GetPriceStream() const;
 
 private:
-	PriceStream<T>* priceStream;
+	PriceStream<T> priceStream;
 
 };
 
 template<typename T>
-AlgoStream<T>::AlgoStream(const T& _product, const PriceStreamOrder& _bidOrder, const PriceStreamOrder& _offerOrder)
+AlgoStream<T>::AlgoStream(const T& _product, const PriceStreamOrder& _bidOrder, const PriceStreamOrder& _offerOrder) :
+	priceStream(_product, _bidOrder, _offerOrder)
 {
-	priceStream = new PriceStream<T>(_product, _bidOrder, _offerOrder);
 }
 
 template<typename T>
-PriceStream<T>* AlgoStream<T>::GetPriceStream() const
+PriceStream<T>* AlgoStream<T>::GetPriceStream()
 {
-	return priceStream;
+	return &priceStream;
+}
+
+template<typename T>
+const PriceStream<T>* AlgoStream<T>::GetPriceStream() const
+{
+	return &priceStream;
 }
 
 /**
@@ -0,0 +1,84 @@
+/**
+* allocationtest.cpp
+* Counts heap allocations per event on the algo execution and algo streaming paths.
+* Built on its own, and excluded from the trading system project, since it
+* replaces the global operator new:
+*     g++ -std=c++14 -O2 allocationtest.cpp -o allocationtest
+* Exits with a failure when an event allocates in steady state.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#include <cstdlib>
+#include <new>
+#include <iostream>
+
+static long allocationCount = 0;
+
+// Keep the replaced operator delete out of line, so the compiler does not pair the
+// free inside it with the operator new of the caller and warn of a mismatch.
+#if defined(_MSC_VER)
+#define ALLOCATION_NOINLINE __declspec(noinline)
+#else
+#define ALLOCATION_NOINLINE __attribute__((noinline))
+#endif
+
+void* operator new(size_t _size)
+{
+	allocationCount++;
+	void* _pointer = malloc(_size ? _size : 1);
+	if (!_pointer) throw std::bad_alloc();
+	return _pointer;
+}
+
+ALLOCATION_NOINLINE void operator delete(void* _pointer) noexcept
+{
+	free(_pointer);
+}
+
+ALLOCATION_NOINLINE void operator delete(void* _pointer, size_t) noexcept
+{
+	free(_pointer);
+}
+
+#include "algoexecutionservice.hpp"
+#include "algostreamingservice.hpp"
+
+using namespace std;
+
+// Run an event repeatedly after a warm up, and get the allocations per event
+template<typename F>
+double CountAllocations(F _event, long _events)
+{
+	_event();
+	long _start = allocationCount;
+	for (long i = 0; i < _events; i++)
+	{
+		_event();
+	}
+	return (double)(allocationCount - _start) / _events;
+}
+
+int main()
+{
+	const long _events = 100000;
+	Bond _bond = GetBond("9128283H1");
+
+	AlgoExecutionService<Bond> _algoExecutionService;
+	array<Order, 5> _bidStack;
+	array<Order, 5> _offerStack;
+	_bidStack.fill(Order(0.0, 0, BID));
+	_offerStack.fill(Order(0.0, 0, OFFER));
+	_bidStack[0] = Order(99.5, 1000000, BID);
+	_offerStack[0] = Order(99.5 + 1.0 / 256.0, 1000000, OFFER);
+	OrderBook<Bond> _orderBook(_bond, _bidStack, _offerStack);
+	double _executionAllocations = CountAllocations([&]() { _algoExecutionService.AlgoExecuteOrder(_orderBook); }, _events);
+
+	AlgoStreamingService<Bond> _algoStreamingService;
+	Price<Bond> _price(_bond, 99.5, 1.0 / 128.0);
+	double _streamingAllocations = CountAllocations([&]() { _algoStreamingService.AlgoPublishPrice(_price); }, _events);
+
+	cout << "Allocations per algo execution: " << _executionAllocations << endl;
+	cout << "Allocations per algo stream: " << _streamingAllocations << endl;
+	return _executionAllocations == 0.0 && _streamingAllocations == 0.0 ? 0 : 1;
+}
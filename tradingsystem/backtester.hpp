@@ -0,0 +1,478 @@
+/**
+* backtester.hpp
+* Defines the backtesting harness for the algo execution parameters.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef BACKTESTER_HPP
+#define BACKTESTER_HPP
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+#include "soa.hpp"
+#include "marketdataservice.hpp"
+#include "algoexecutionservice.hpp"
+
+using namespace std;
+
+/**
+* Parameters of one algo execution configuration.
+*/
+class BacktestParameters
+{
+
+public:
+
+	// ctor for backtest parameters
+	BacktestParameters() = default;
+	BacktestParameters(double _spread, long _count);
+
+	// Get the widest spread the algo crosses
+	double GetSpread() const;
+
+	// Get the starting signal count
+	long GetCount() const;
+
+private:
+
+	double spread;
+	long count;
+
+};
+
+BacktestParameters::BacktestParameters(double _spread, long _count) :
+	spread(_spread), count(_count) {}
+
+double BacktestParameters::GetSpread() const
+{
+	return spread;
+}
+
+long BacktestParameters::GetCount() const
+{
+	return count;
+}
+
+/**
+* Outcome of backtesting one configuration.
+* PnL marks open positions at the last mid, and slippage is the average price
+* given up per unit filled against the price the order was sent at.
+*/
+class BacktestResult
+{
+
+public:
+
+	// ctor for a backtest result
+	BacktestResult() = default;
+	BacktestResult(const BacktestParameters& _parameters, long _orderCount, long _orderedQuantity, long _filledQuantity, double _pnl, double _slippage, double _runtime);
+
+	// Get the parameters
+	const BacktestParameters& GetParameters() const;
+
+	// Get the number of orders sent
+	long GetOrderCount() const;
+
+	// Get the quantity ordered
+	long GetOrderedQuantity() const;
+
+	// Get the quantity filled
+	long GetFilledQuantity() const;
+
+	// Get the fraction of the ordered quantity filled
+	double GetFillRate() const;
+
+	// Get the PnL
+	double GetPnL() const;
+
+	// Get the average slippage per unit filled
+	double GetSlippage() const;
+
+	// Get the runtime in seconds
+	double GetRuntime() const;
+
+	// Change attributes to strings
+	vector<string> ToStrings() const;
+
+private:
+
+	BacktestParameters parameters;
+	long orderCount;
+	long orderedQuantity;
+	long filledQuantity;
+	double pnl;
+	double slippage;
+	double runtime;
+
+};
+
+BacktestResult::BacktestResult(const BacktestParameters& _parameters, long _orderCount, long _orderedQuantity, long _filledQuantity, double _pnl, double _slippage, double _runtime) :
+	parameters(_parameters), orderCount(_orderCount), orderedQuantity(_orderedQuantity), filledQuantity(_filledQuantity), pnl(_pnl), slippage(_slippage), runtime(_runtime) {}
+
+const BacktestParameters& BacktestResult::GetParameters() const
+{
+	return parameters;
+}
+
+long BacktestResult::GetOrderCount() const
+{
+	return orderCount;
+}
+
+long BacktestResult::GetOrderedQuantity() const
+{
+	return orderedQuantity;
+}
+
+long BacktestResult::GetFilledQuantity() const
+{
+	return filledQuantity;
+}
+
+double BacktestResult::GetFillRate() const
+{
+	return orderedQuantity > 0 ? (double)filledQuantity / orderedQuantity : 0.0;
+}
+
+double BacktestResult::GetPnL() const
+{
+	return pnl;
+}
+
+double BacktestResult::GetSlippage() const
+{
+	return slippage;
+}
+
+double BacktestResult::GetRuntime() const
+{
+	return runtime;
+}
+
+vector<string> BacktestResult::ToStrings() const
+{
+	vector<string> _strings;
+	_strings.push_back(to_string(parameters.GetSpread()));
+	_strings.push_back(to_string(parameters.GetCount()));
+	_strings.push_back(to_string(orderCount));
+	_strings.push_back(to_string(orderedQuantity));
+	_strings.push_back(to_string(filledQuantity));
+	_strings.push_back(to_string(GetFillRate()));
+	_strings.push_back(to_string(pnl));
+	_strings.push_back(to_string(slippage));
+	_strings.push_back(to_string(runtime));
+	return _strings;
+}
+
+/**
+* Simulated venue for one backtest run, listening to the orders of its own algo.
+* An order waits for the next book of its product and fills there against the
+* best level it would hit, up to the size shown, so it pays for the book moving
+* while it is in flight. Cash and positions are kept per product.
+* Type T is the product type.
+*/
+template<typename T>
+class BacktestSimulator : public ServiceListener<AlgoExecution<T>>
+{
+
+public:
+
+	// ctor for a backtest simulator
+	BacktestSimulator();
+
+	// Fill the order waiting on a product against its new book of any depth and mark the product
+	template<size_t N>
+	void ProcessBook(const OrderBook<T, N>& _orderBook);
+
+	// Get the result of the run
+	BacktestResult GetResult(const BacktestParameters& _parameters, double _runtime) const;
+
+	// Listener callback to process an add event to the Service
+	void ProcessAdd(AlgoExecution<T>& _data);
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(AlgoExecution<T>& _data);
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(AlgoExecution<T>& _data);
+
+private:
+
+	struct ProductState
+	{
+		bool hasOrder;
+		bool isBuy;
+		double orderPrice;
+		long orderQuantity;
+		long position;
+		double cash;
+		double mid;
+	};
+
+	unordered_map<string, ProductState> products;
+	long orderCount;
+	long orderedQuantity;
+	long filledQuantity;
+	double slippageCost;
+
+};
+
+template<typename T>
+BacktestSimulator<T>::BacktestSimulator()
+{
+	products = unordered_map<string, ProductState>();
+	orderCount = 0;
+	orderedQuantity = 0;
+	filledQuantity = 0;
+	slippageCost = 0.0;
+}
+
+template<typename T>
+template<size_t N>
+void BacktestSimulator<T>::ProcessBook(const OrderBook<T, N>& _orderBook)
+{
+	ProductState& _state = products[_orderBook.GetProduct().GetProductId()];
+	BidOffer _bidOffer = _orderBook.GetBidOffer();
+	const Order& _bidOrder = _bidOffer.GetBidOrder();
+	const Order& _offerOrder = _bidOffer.GetOfferOrder();
+
+	if (_state.hasOrder)
+	{
+		const Order& _level = _state.isBuy ? _offerOrder : _bidOrder;
+		long _quantity = min(_state.orderQuantity, _level.GetQuantity());
+		double _price = _level.GetPrice();
+		if (_quantity > 0)
+		{
+			double _value = _price * _quantity / 100.0;
+			_state.position += _state.isBuy ? _quantity : -_quantity;
+			_state.cash += _state.isBuy ? -_value : _value;
+			slippageCost += (_state.isBuy ? _price - _state.orderPrice : _state.orderPrice - _price) * _quantity;
+			filledQuantity += _quantity;
+		}
+		_state.hasOrder = false;
+	}
+	_state.mid = (_bidOrder.GetPrice() + _offerOrder.GetPrice()) / 2.0;
+}
+
+template<typename T>
+BacktestResult BacktestSimulator<T>::GetResult(const BacktestParameters& _parameters, double _runtime) const
+{
+	double _pnl = 0.0;
+	for (auto& p : products)
+	{
+		_pnl += p.second.cash + p.second.position * p.second.mid / 100.0;
+	}
+	double _slippage = filledQuantity > 0 ? slippageCost / filledQuantity : 0.0;
+	return BacktestResult(_parameters, orderCount, orderedQuantity, filledQuantity, _pnl, _slippage, _runtime);
+}
+
+template<typename T>
+void BacktestSimulator<T>::ProcessAdd(AlgoExecution<T>& _data)
+{
+	// An order on the bid sells into the bids, an order on the offer buys from the offers.
+	const ExecutionOrder<T>* _order = _data.GetExecutionOrder();
+	ProductState& _state = products[_order->GetProduct().GetProductId()];
+	_state.hasOrder = true;
+	_state.isBuy = _order->GetPricingSide() == OFFER;
+	_state.orderPrice = _order->GetPrice();
+	_state.orderQuantity = _order->GetVisibleQuantity() + _order->GetHiddenQuantity();
+	orderCount++;
+	orderedQuantity += _state.orderQuantity;
+}
+
+template<typename T>
+void BacktestSimulator<T>::ProcessRemove(AlgoExecution<T>& _data) {}
+
+template<typename T>
+void BacktestSimulator<T>::ProcessUpdate(AlgoExecution<T>& _data) {}
+
+/**
+* Pre-declearations to avoid errors.
+*/
+template<typename T, size_t N = 5>
+class BacktesterToMarketDataListener;
+
+/**
+* Backtesting harness replaying stored order books through the algo execution.
+* Every configuration runs on its own AlgoExecutionService and simulator over
+* the same read-only books, and configurations are spread over worker threads.
+* Type T is the product type.
+* N is the book depth.
+*/
+template<typename T, size_t N = 5>
+class Backtester
+{
+
+public:
+
+	// ctor for a backtester
+	Backtester();
+
+	// Store an order book to replay
+	void AddBook(const OrderBook<T, N>& _orderBook);
+
+	// Get the number of stored order books
+	long GetBookCount() const;
+
+	// Get the listener storing order books from Market Data Service
+	BacktesterToMarketDataListener<T, N>* GetListener();
+
+	// Backtest one configuration
+	BacktestResult Run(const BacktestParameters& _parameters) const;
+
+	// Backtest configurations in parallel, on every core when no thread count is given
+	vector<BacktestResult> Run(const vector<BacktestParameters>& _parameters, unsigned int _threads = 0) const;
+
+	// Get the grid of every spread with every starting count
+	static vector<BacktestParameters> GetGrid(const vector<double>& _spreads, const vector<long>& _counts);
+
+private:
+
+	vector<OrderBook<T, N>> books;
+	BacktesterToMarketDataListener<T, N>* listener;
+
+};
+
+template<typename T, size_t N>
+Backtester<T, N>::Backtester()
+{
+	books = vector<OrderBook<T, N>>();
+	listener = new BacktesterToMarketDataListener<T, N>(this);
+}
+
+template<typename T, size_t N>
+void Backtester<T, N>::AddBook(const OrderBook<T, N>& _orderBook)
+{
+	books.push_back(_orderBook);
+}
+
+template<typename T, size_t N>
+long Backtester<T, N>::GetBookCount() const
+{
+	return books.size();
+}
+
+template<typename T, size_t N>
+BacktesterToMarketDataListener<T, N>* Backtester<T, N>::GetListener()
+{
+	return listener;
+}
+
+template<typename T, size_t N>
+BacktestResult Backtester<T, N>::Run(const BacktestParameters& _parameters) const
+{
+	auto _start = chrono::steady_clock::now();
+	AlgoExecutionService<T, N> _algoExecutionService;
+	BacktestSimulator<T> _simulator;
+	_algoExecutionService.SetSpread(_parameters.GetSpread());
+	_algoExecutionService.SetCount(_parameters.GetCount());
+	_algoExecutionService.AddListener(&_simulator);
+
+	for (auto& b : books)
+	{
+		_simulator.ProcessBook(b);
+		_algoExecutionService.AlgoExecuteOrder(b);
+	}
+
+	double _runtime = chrono::duration<double>(chrono::steady_clock::now() - _start).count();
+	return _simulator.GetResult(_parameters, _runtime);
+}
+
+template<typename T, size_t N>
+vector<BacktestResult> Backtester<T, N>::Run(const vector<BacktestParameters>& _parameters, unsigned int _threads) const
+{
+	if (_threads == 0) _threads = max(1u, thread::hardware_concurrency());
+	vector<BacktestResult> _results(_parameters.size());
+	atomic<size_t> _next(0);
+	auto _work = [&]()
+	{
+		for (size_t i = _next++; i < _parameters.size(); i = _next++)
+		{
+			_results[i] = Run(_parameters[i]);
+		}
+	};
+
+	vector<thread> _workers;
+	for (unsigned int i = 1; i < _threads && i < _parameters.size(); i++)
+	{
+		_workers.push_back(thread(_work));
+	}
+	_work();
+	for (auto& w : _workers)
+	{
+		w.join();
+	}
+	return _results;
+}
+
+template<typename T, size_t N>
+vector<BacktestParameters> Backtester<T, N>::GetGrid(const vector<double>& _spreads, const vector<long>& _counts)
+{
+	vector<BacktestParameters> _grid;
+	for (auto& s : _spreads)
+	{
+		for (auto& c : _counts)
+		{
+			_grid.push_back(BacktestParameters(s, c));
+		}
+	}
+	return _grid;
+}
+
+/**
+* Backtester Listener storing order books from Market Data Service.
+* Type T is the product type.
+* N is the book depth.
+*/
+template<typename T, size_t N>
+class BacktesterToMarketDataListener : public ServiceListener<OrderBook<T, N>>
+{
+
+private:
+
+	Backtester<T, N>* service;
+
+public:
+
+	// Connector and Destructor
+	BacktesterToMarketDataListener(Backtester<T, N>* _service);
+	~BacktesterToMarketDataListener();
+
+	// Listener callback to process an add event to the Service
+	void ProcessAdd(OrderBook<T, N>& _data);
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(OrderBook<T, N>& _data);
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(OrderBook<T, N>& _data);
+
+};
+
+template<typename T, size_t N>
+BacktesterToMarketDataListener<T, N>::BacktesterToMarketDataListener(Backtester<T, N>* _service)
+{
+	service = _service;
+}
+
+template<typename T, size_t N>
+BacktesterToMarketDataListener<T, N>::~BacktesterToMarketDataListener() {}
+
+template<typename T, size_t N>
+void BacktesterToMarketDataListener<T, N>::ProcessAdd(OrderBook<T, N>& _data)
+{
+	service->AddBook(_data);
+}
+
+template<typename T, size_t N>
+void BacktesterToMarketDataListener<T, N>::ProcessRemove(OrderBook<T, N>& _data) {}
+
+template<typename T, size_t N>
+void BacktesterToMarketDataListener<T, N>::ProcessUpdate(OrderBook<T, N>& _data) {}
+
+#endif
@@ -0,0 +1,532 @@
+/**
+* bookanalyticsservice.hpp
+* Defines the data types and Service for incremental order book analytics.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef BOOK_ANALYTICS_SERVICE_HPP
+#define BOOK_ANALYTICS_SERVICE_HPP
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include "soa.hpp"
+#include "marketdataservice.hpp"
+
+using namespace std;
+
+/**
+* A fixed size rolling window keeping running sums of its samples.
+* Adding a sample evicts the oldest one, so mean and variance are O(1).
+*/
+class RollingWindow
+{
+
+public:
+
+	// ctor for a rolling window
+	RollingWindow() = default;
+	RollingWindow(long _size);
+
+	// Add a sample to the window
+	void Add(double _sample);
+
+	// Get the number of samples in the window
+	long GetCount() const;
+
+	// Get the mean of the samples in the window
+	double GetMean() const;
+
+	// Get the standard deviation of the samples in the window
+	double GetStdDev() const;
+
+private:
+	vector<double> samples;
+	long size;
+	long count;
+	long next;
+	double sum;
+	double sumSquare;
+
+};
+
+RollingWindow::RollingWindow(long _size)
+{
+	samples = vector<double>(_size, 0.0);
+	size = _size;
+	count = 0;
+	next = 0;
+	sum = 0.0;
+	sumSquare = 0.0;
+}
+
+void RollingWindow::Add(double _sample)
+{
+	double _oldest = samples[next];
+	if (count == size)
+	{
+		sum -= _oldest;
+		sumSquare -= _oldest * _oldest;
+	}
+	else
+	{
+		count++;
+	}
+	samples[next] = _sample;
+	sum += _sample;
+	sumSquare += _sample * _sample;
+	next = (next + 1) % size;
+}
+
+long RollingWindow::GetCount() const
+{
+	return count;
+}
+
+double RollingWindow::GetMean() const
+{
+	if (count == 0) return 0.0;
+	return sum / count;
+}
+
+double RollingWindow::GetStdDev() const
+{
+	if (count < 2) return 0.0;
+	double _mean = sum / count;
+	double _variance = (sumSquare - count * _mean * _mean) / (count - 1);
+	if (_variance < 0.0) _variance = 0.0;
+	return sqrt(_variance);
+}
+
+/**
+* Order book analytics for a product, refreshed on every order book update.
+* Type T is the product type.
+*/
+template<typename T>
+class BookAnalytics
+{
+
+public:
+
+	// ctor for book analytics
+	BookAnalytics();
+	BookAnalytics(const T& _product);
+
+	// Get the product
+	const T& GetProduct() const;
+
+	// Get the best bid/offer order
+	const BidOffer& GetBidOffer() const;
+
+	// Get the mid price of the top of book
+	double GetMid() const;
+
+	// Get the top of book spread
+	double GetSpread() const;
+
+	// Get the size weighted microprice of the top of book
+	double GetMicroPrice() const;
+
+	// Get the size imbalance over the top levels, between -1 (all offer) and 1 (all bid)
+	double GetImbalance() const;
+
+	// Get the mid of the size weighted bid and offer prices over the top levels
+	double GetDepthWeightedMid() const;
+
+	// Get the rolling mean of the top of book spread
+	double GetRollingSpread() const;
+
+	// Get the rolling standard deviation of mid price changes
+	double GetRollingVolatility() const;
+
+	// Get the number of order book updates seen
+	long GetUpdateCount() const;
+
+	// Refresh the analytics with an order book update of any depth
+	template<size_t N>
+	void Update(const OrderBook<T, N>& _orderBook, int _levels, RollingWindow& _spreads, RollingWindow& _midChanges);
+
+	// Change attributes to strings
+	vector<string> ToStrings() const;
+
+private:
+	T product;
+	BidOffer bidOffer;
+	double mid;
+	double spread;
+	double microPrice;
+	double imbalance;
+	double depthWeightedMid;
+	double rollingSpread;
+	double rollingVolatility;
+	long updateCount;
+
+};
+
+template<typename T>
+BookAnalytics<T>::BookAnalytics()
+{
+	mid = 0.0;
+	spread = 0.0;
+	microPrice = 0.0;
+	imbalance = 0.0;
+	depthWeightedMid = 0.0;
+	rollingSpread = 0.0;
+	rollingVolatility = 0.0;
+	updateCount = 0;
+}
+
+template<typename T>
+BookAnalytics<T>::BookAnalytics(const T& _product) :
+	product(_product)
+{
+	mid = 0.0;
+	spread = 0.0;
+	microPrice = 0.0;
+	imbalance = 0.0;
+	depthWeightedMid = 0.0;
+	rollingSpread = 0.0;
+	rollingVolatility = 0.0;
+	updateCount = 0;
+}
+
+template<typename T>
+const T& BookAnalytics<T>::GetProduct() const
+{
+	return product;
+}
+
+template<typename T>
+const BidOffer& BookAnalytics<T>::GetBidOffer() const
+{
+	return bidOffer;
+}
+
+template<typename T>
+double BookAnalytics<T>::GetMid() const
+{
+	return mid;
+}
+
+template<typename T>
+double BookAnalytics<T>::GetSpread() const
+{
+	return spread;
+}
+
+template<typename T>
+double BookAnalytics<T>::GetMicroPrice() const
+{
+	return microPrice;
+}
+
+template<typename T>
+double BookAnalytics<T>::GetImbalance() const
+{
+	return imbalance;
+}
+
+template<typename T>
+double BookAnalytics<T>::GetDepthWeightedMid() const
+{
+	return depthWeightedMid;
+}
+
+template<typename T>
+double BookAnalytics<T>::GetRollingSpread() const
+{
+	return rollingSpread;
+}
+
+template<typename T>
+double BookAnalytics<T>::GetRollingVolatility() const
+{
+	return rollingVolatility;
+}
+
+template<typename T>
+long BookAnalytics<T>::GetUpdateCount() const
+{
+	return updateCount;
+}
+
+template<typename T>
+template<size_t N>
+void BookAnalytics<T>::Update(const OrderBook<T, N>& _orderBook, int _levels, RollingWindow& _spreads, RollingWindow& _midChanges)
+{
+	const auto& _bidStack = _orderBook.GetBidStack();
+	const auto& _offerStack = _orderBook.GetOfferStack();
+	bidOffer = _orderBook.GetBidOffer();
+
+	// The connector delivers each stack in level order, so the top levels are at the front.
+	long _bidQuantity = 0;
+	double _bidNotional = 0.0;
+	for (int i = 0; i < _levels && i < (int)_bidStack.size(); i++)
+	{
+		_bidQuantity += _bidStack[i].GetQuantity();
+		_bidNotional += _bidStack[i].GetPrice() * _bidStack[i].GetQuantity();
+	}
+	long _offerQuantity = 0;
+	double _offerNotional = 0.0;
+	for (int i = 0; i < _levels && i < (int)_offerStack.size(); i++)
+	{
+		_offerQuantity += _offerStack[i].GetQuantity();
+		_offerNotional += _offerStack[i].GetPrice() * _offerStack[i].GetQuantity();
+	}
+
+	double _bidPrice = bidOffer.GetBidOrder().GetPrice();
+	double _offerPrice = bidOffer.GetOfferOrder().GetPrice();
+	double _topBidQuantity = bidOffer.GetBidOrder().GetQuantity();
+	double _topOfferQuantity = bidOffer.GetOfferOrder().GetQuantity();
+	double _lastMid = mid;
+
+	mid = (_bidPrice + _offerPrice) / 2.0;
+	spread = _offerPrice - _bidPrice;
+	if (_topBidQuantity + _topOfferQuantity > 0)
+		microPrice = (_bidPrice * _topOfferQuantity + _offerPrice * _topBidQuantity) / (_topBidQuantity + _topOfferQuantity);
+	else
+		microPrice = mid;
+	if (_bidQuantity + _offerQuantity > 0)
+		imbalance = (double)(_bidQuantity - _offerQuantity) / (double)(_bidQuantity + _offerQuantity);
+	else
+		imbalance = 0.0;
+	if (_bidQuantity > 0 && _offerQuantity > 0)
+		depthWeightedMid = (_bidNotional / _bidQuantity + _offerNotional / _offerQuantity) / 2.0;
+	else
+		depthWeightedMid = mid;
+
+	_spreads.Add(spread);
+	if (updateCount > 0) _midChanges.Add(mid - _lastMid);
+	rollingSpread = _spreads.GetMean();
+	rollingVolatility = _midChanges.GetStdDev();
+	updateCount++;
+}
+
+template<typename T>
+vector<string> BookAnalytics<T>::ToStrings() const
+{
+	string _product = product.GetProductId();
+	string _mid = ConvertPrice(mid);
+	string _spread = to_string(spread);
+	string _microPrice = to_string(microPrice);
+	string _imbalance = to_string(imbalance);
+	string _depthWeightedMid = to_string(depthWeightedMid);
+	string _rollingSpread = to_string(rollingSpread);
+	string _rollingVolatility = to_string(rollingVolatility);
+
+	vector<string> _strings;
+	_strings.push_back(_product);
+	_strings.push_back(_mid);
+	_strings.push_back(_spread);
+	_strings.push_back(_microPrice);
+	_strings.push_back(_imbalance);
+	_strings.push_back(_depthWeightedMid);
+	_strings.push_back(_rollingSpread);
+	_strings.push_back(_rollingVolatility);
+	return _strings;
+}
+
+/**
+* Pre-declearations to avoid errors.
+*/
+template<typename T, size_t N = 5>
+class BookAnalyticsToMarketDataListener;
+
+/**
+* Book Analytics Service maintaining order book analytics incrementally on each update.
+* Keyed on product identifier.
+* Type T is the product type.
+* N is the book depth.
+*/
+template<typename T, size_t N = 5>
+class BookAnalyticsService : public Service<string, BookAnalytics<T>>
+{
+
+private:
+
+	map<string, BookAnalytics<T>> bookAnalytics;
+	map<string, RollingWindow> spreads;
+	map<string, RollingWindow> midChanges;
+	vector<ServiceListener<BookAnalytics<T>>*> listeners;
+	BookAnalyticsToMarketDataListener<T, N>* listener;
+	int levels;
+	long window;
+
+public:
+
+	// Constructor and destructor
+	BookAnalyticsService();
+	BookAnalyticsService(int _levels, long _window);
+	~BookAnalyticsService();
+
+	// Get data on our service given a key
+	BookAnalytics<T>& GetData(string _key);
+
+	// The callback that a Connector should invoke for any new or updated data
+	void OnMessage(BookAnalytics<T>& _data);
+
+	// Add a listener to the Service for callbacks on add, remove, and update events for data to the Service
+	void AddListener(ServiceListener<BookAnalytics<T>>* _listener);
+
+	// Get all listeners on the Service
+	const vector<ServiceListener<BookAnalytics<T>>*>& GetListeners() const;
+
+	// Get the listener of the service
+	BookAnalyticsToMarketDataListener<T, N>* GetListener();
+
+	// Get the number of top levels used for imbalance and depth weighted mid
+	int GetLevels() const;
+
+	// Get the number of updates in the rolling window
+	long GetWindow() const;
+
+	// Update the analytics with an order book
+	void UpdateBook(OrderBook<T, N>& _orderBook);
+
+};
+
+template<typename T, size_t N>
+BookAnalyticsService<T, N>::BookAnalyticsService()
+{
+	bookAnalytics = map<string, BookAnalytics<T>>();
+	spreads = map<string, RollingWindow>();
+	midChanges = map<string, RollingWindow>();
+	listeners = vector<ServiceListener<BookAnalytics<T>>*>();
+	listener = new BookAnalyticsToMarketDataListener<T, N>(this);
+	levels = 5;
+	window = 100;
+}
+
+template<typename T, size_t N>
+BookAnalyticsService<T, N>::BookAnalyticsService(int _levels, long _window)
+{
+	bookAnalytics = map<string, BookAnalytics<T>>();
+	spreads = map<string, RollingWindow>();
+	midChanges = map<string, RollingWindow>();
+	listeners = vector<ServiceListener<BookAnalytics<T>>*>();
+	listener = new BookAnalyticsToMarketDataListener<T, N>(this);
+	levels = _levels;
+	window = _window;
+}
+
+template<typename T, size_t N>
+BookAnalyticsService<T, N>::~BookAnalyticsService() {}
+
+template<typename T, size_t N>
+BookAnalytics<T>& BookAnalyticsService<T, N>::GetData(string _key)
+{
+	return bookAnalytics[_key];
+}
+
+template<typename T, size_t N>
+void BookAnalyticsService<T, N>::OnMessage(BookAnalytics<T>& _data)
+{
+	bookAnalytics[_data.GetProduct().GetProductId()] = _data;
+}
+
+template<typename T, size_t N>
+void BookAnalyticsService<T, N>::AddListener(ServiceListener<BookAnalytics<T>>* _listener)
+{
+	listeners.push_back(_listener);
+}
+
+template<typename T, size_t N>
+const vector<ServiceListener<BookAnalytics<T>>*>& BookAnalyticsService<T, N>::GetListeners() const
+{
+	return listeners;
+}
+
+template<typename T, size_t N>
+BookAnalyticsToMarketDataListener<T, N>* BookAnalyticsService<T, N>::GetListener()
+{
+	return listener;
+}
+
+template<typename T, size_t N>
+int BookAnalyticsService<T, N>::GetLevels() const
+{
+	return levels;
+}
+
+template<typename T, size_t N>
+long BookAnalyticsService<T, N>::GetWindow() const
+{
+	return window;
+}
+
+template<typename T, size_t N>
+void BookAnalyticsService<T, N>::UpdateBook(OrderBook<T, N>& _orderBook)
+{
+	const T& _product = _orderBook.GetProduct();
+	string _productId = _product.GetProductId();
+
+	auto _iter = bookAnalytics.find(_productId);
+	if (_iter == bookAnalytics.end())
+	{
+		_iter = bookAnalytics.insert(make_pair(_productId, BookAnalytics<T>(_product))).first;
+		spreads.insert(make_pair(_productId, RollingWindow(window)));
+		midChanges.insert(make_pair(_productId, RollingWindow(window)));
+	}
+
+	BookAnalytics<T>& _bookAnalytics = _iter->second;
+	_bookAnalytics.Update(_orderBook, levels, spreads[_productId], midChanges[_productId]);
+
+	for (auto& l : listeners)
+	{
+		l->ProcessAdd(_bookAnalytics);
+	}
+}
+
+/**
+* Book Analytics Service Listener subscribing data from Market Data Service to Book Analytics Service.
+* Type T is the product type.
+* N is the book depth.
+*/
+template<typename T, size_t N>
+class BookAnalyticsToMarketDataListener : public ServiceListener<OrderBook<T, N>>
+{
+
+private:
+
+	BookAnalyticsService<T, N>* service;
+
+public:
+
+	// Connector and Destructor
+	BookAnalyticsToMarketDataListener(BookAnalyticsService<T, N>* _service);
+	~BookAnalyticsToMarketDataListener();
+
+	// Listener callback to process an add event to the Service
+	void ProcessAdd(OrderBook<T, N>& _data);
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(OrderBook<T, N>& _data);
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(OrderBook<T, N>& _data);
+
+};
+
+template<typename T, size_t N>
+BookAnalyticsToMarketDataListener<T, N>::BookAnalyticsToMarketDataListener(BookAnalyticsService<T, N>* _service)
+{
+	service = _service;
+}
+
+template<typename T, size_t N>
+BookAnalyticsToMarketDataListener<T, N>::~BookAnalyticsToMarketDataListener() {}
+
+template<typename T, size_t N>
+void BookAnalyticsToMarketDataListener<T, N>::ProcessAdd(OrderBook<T, N>& _data)
+{
+	service->UpdateBook(_data);
+}
+
+template<typename T, size_t N>
+void BookAnalyticsToMarketDataListener<T, N>::ProcessRemove(OrderBook<T, N>& _data) {}
+
+template<typename T, size_t N>
+void BookAnalyticsToMarketDataListener<T, N>::ProcessUpdate(OrderBook<T, N>& _data) {}
+
+#endif
@@ -0,0 +1,561 @@
+/**
+* checkpoint.hpp
+* Defines binary checkpoints of positions and risk for a fast restart.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "soa.hpp"
+#include "riskservice.hpp"
+
+using namespace std;
+
+// Version of the checkpoint layout
+const unsigned int CHECKPOINT_VERSION = 1;
+
+// Longest product identifier or book name a checkpoint holds, with its terminator
+const int CHECKPOINT_NAME_SIZE = 32;
+
+/**
+* Layout of a checkpoint file: a header, then the position of every product in
+* every book, then the PV01 of every product. Records are fixed size and naturally
+* aligned, so a mapped file is read in place.
+*/
+struct CheckpointHeader
+{
+	char magic[4];
+	unsigned int version;
+	long long tradeCount;
+	long long positionCount;
+	long long pv01Count;
+};
+
+struct CheckpointPosition
+{
+	char productId[CHECKPOINT_NAME_SIZE];
+	char book[CHECKPOINT_NAME_SIZE];
+	long long position;
+};
+
+struct CheckpointPV01
+{
+	char productId[CHECKPOINT_NAME_SIZE];
+	double pv01;
+	long long quantity;
+};
+
+/**
+* Read-only memory mapping of a whole file.
+*/
+class MappedFile
+{
+
+public:
+
+	// ctor for an unmapped file
+	MappedFile();
+	~MappedFile();
+
+	// Map a file, and get whether it could be mapped
+	bool Open(const string& _path);
+
+	// Unmap the file
+	void Close();
+
+	// Get the mapped bytes
+	const char* GetData() const;
+
+	// Get the number of mapped bytes
+	size_t GetSize() const;
+
+private:
+
+	const char* data;
+	size_t size;
+#if defined(_WIN32)
+	HANDLE file;
+	HANDLE mapping;
+#endif
+
+	// Mappings are not copied
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+};
+
+MappedFile::MappedFile()
+{
+	data = nullptr;
+	size = 0;
+#if defined(_WIN32)
+	file = INVALID_HANDLE_VALUE;
+	mapping = NULL;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const string& _path)
+{
+	Close();
+#if defined(_WIN32)
+	file = CreateFileA(_path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER _size;
+	if (!GetFileSizeEx(file, &_size) || _size.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		Close();
+		return false;
+	}
+	data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		Close();
+		return false;
+	}
+	size = (size_t)_size.QuadPart;
+#else
+	int _file = open(_path.c_str(), O_RDONLY);
+	if (_file < 0) return false;
+	struct stat _stat;
+	if (fstat(_file, &_stat) != 0 || _stat.st_size == 0)
+	{
+		close(_file);
+		return false;
+	}
+	void* _data = mmap(nullptr, _stat.st_size, PROT_READ, MAP_PRIVATE, _file, 0);
+	close(_file);
+	if (_data == MAP_FAILED) return false;
+	data = (const char*)_data;
+	size = _stat.st_size;
+#endif
+	return true;
+}
+
+void MappedFile::Close()
+{
+#if defined(_WIN32)
+	if (data) UnmapViewOfFile(data);
+	if (mapping != NULL) CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+	mapping = NULL;
+	file = INVALID_HANDLE_VALUE;
+#else
+	if (data) munmap((void*)data, size);
+#endif
+	data = nullptr;
+	size = 0;
+}
+
+const char* MappedFile::GetData() const
+{
+	return data;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return size;
+}
+
+/**
+* Writer of checkpoint files on a background thread.
+* The service thread hands over a finished image and goes on; the writer puts it
+* in a temporary file and renames it over the checkpoint, so a crash mid-write
+* leaves the previous checkpoint intact. When images come faster than they are
+* written, only the latest one is kept.
+*/
+class CheckpointWriter
+{
+
+public:
+
+	// ctor for a writer of a checkpoint file
+	CheckpointWriter(const string& _path);
+	~CheckpointWriter();
+
+	// Hand over an image to write
+	void Write(vector<char>& _image);
+
+	// Wait until every image handed over is written
+	void Flush();
+
+private:
+
+	string path;
+	vector<char> pending;
+	bool hasPending;
+	bool writing;
+	bool stopping;
+	mutex lock;
+	condition_variable ready;
+	thread worker;
+
+	// Write images until stopped
+	void Run();
+
+	// Write an image to the checkpoint file
+	bool WriteFile(const vector<char>& _image) const;
+
+};
+
+CheckpointWriter::CheckpointWriter(const string& _path)
+{
+	path = _path;
+	pending = vector<char>();
+	hasPending = false;
+	writing = false;
+	stopping = false;
+	worker = thread(&CheckpointWriter::Run, this);
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+	{
+		lock_guard<mutex> _guard(lock);
+		stopping = true;
+	}
+	ready.notify_all();
+	worker.join();
+}
+
+void CheckpointWriter::Write(vector<char>& _image)
+{
+	{
+		lock_guard<mutex> _guard(lock);
+		pending.swap(_image);
+		hasPending = true;
+	}
+	ready.notify_all();
+}
+
+void CheckpointWriter::Flush()
+{
+	unique_lock<mutex> _guard(lock);
+	ready.wait(_guard, [this] { return !hasPending && !writing; });
+}
+
+void CheckpointWriter::Run()
+{
+	vector<char> _image;
+	unique_lock<mutex> _guard(lock);
+	while (true)
+	{
+		ready.wait(_guard, [this] { return hasPending || stopping; });
+		if (!hasPending) break;
+		_image.swap(pending);
+		hasPending = false;
+		writing = true;
+		_guard.unlock();
+		WriteFile(_image);
+		_guard.lock();
+		writing = false;
+		ready.notify_all();
+	}
+}
+
+bool CheckpointWriter::WriteFile(const vector<char>& _image) const
+{
+	string _temporaryPath = path + ".tmp";
+	FILE* _file = fopen(_temporaryPath.c_str(), "wb");
+	if (!_file) return false;
+	bool _written = fwrite(_image.data(), 1, _image.size(), _file) == _image.size();
+	_written = fflush(_file) == 0 && _written;
+	fclose(_file);
+	if (!_written)
+	{
+		remove(_temporaryPath.c_str());
+		return false;
+	}
+#if defined(_WIN32)
+	return MoveFileExA(_temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	return rename(_temporaryPath.c_str(), path.c_str()) == 0;
+#endif
+}
+
+/**
+* Pre-declearations to avoid errors.
+*/
+template<typename T>
+class CheckpointToPositionListener;
+
+/**
+* Checkpointer of the positions and risk held by Position Service and Risk Service.
+* A checkpoint is an image of every position and PV01 together with the number of
+* trades the trade booking connector had read, built on the service thread and
+* written by a background writer. It is taken every interval of position updates
+* once the listener is added, or whenever asked. Loading maps the last checkpoint,
+* puts its positions and risk into the services and has the connector skip the
+* trades it already holds, so only later trades are replayed.
+* The trade count is the only progress recorded, so positions must come from the
+* trade file alone when a checkpoint is taken: periodic checkpoints are only taken
+* while the connector is reading trades, and one asked for must be taken before
+* executions book trades of their own. Every trade counted must also be booked, so
+* a periodic checkpoint due while the sequencer holds trades back waits until it
+* has none. Restored positions are published, so their
+* listeners start from them. PnL, built from trades rather than positions, only
+* covers the trades replayed after the checkpoint.
+* Type T is the product type.
+*/
+template<typename T>
+class Checkpointer
+{
+
+private:
+
+	PositionService<T>* positionService;
+	RiskService<T>* riskService;
+	TradeBookingConnector<T>* tradeBookingConnector;
+	CheckpointWriter writer;
+	CheckpointToPositionListener<T>* listener;
+	string path;
+	vector<char> image;
+	long interval;
+	long updateCount;
+
+	// Copy a name into a record, and get whether it fits
+	static bool CopyName(char* _record, const string& _name);
+
+	// Read a name out of a record
+	static string ReadName(const char* _record);
+
+public:
+
+	// ctor for a checkpointer taking a checkpoint every interval of position updates
+	Checkpointer(PositionService<T>* _positionService, RiskService<T>* _riskService, TradeBookingConnector<T>* _tradeBookingConnector, const string& _path, long _interval);
+	~Checkpointer();
+
+	// Get the listener of the service
+	CheckpointToPositionListener<T>* GetListener();
+
+	// Take a checkpoint, and get whether it could be built
+	bool Checkpoint();
+
+	// Load the last checkpoint, and get whether there was one
+	bool Load();
+
+	// Wait until every checkpoint taken is written
+	void Flush();
+
+	// Count a position update while trades are read, taking a checkpoint once an interval has passed and no trades are held back
+	void ProcessUpdate();
+
+};
+
+template<typename T>
+Checkpointer<T>::Checkpointer(PositionService<T>* _positionService, RiskService<T>* _riskService, TradeBookingConnector<T>* _tradeBookingConnector, const string& _path, long _interval) :
+	writer(_path)
+{
+	positionService = _positionService;
+	riskService = _riskService;
+	tradeBookingConnector = _tradeBookingConnector;
+	listener = new CheckpointToPositionListener<T>(this);
+	path = _path;
+	image = vector<char>();
+	interval = _interval;
+	updateCount = 0;
+}
+
+template<typename T>
+Checkpointer<T>::~Checkpointer() {}
+
+template<typename T>
+CheckpointToPositionListener<T>* Checkpointer<T>::GetListener()
+{
+	return listener;
+}
+
+template<typename T>
+bool Checkpointer<T>::CopyName(char* _record, const string& _name)
+{
+	if (_name.size() >= (size_t)CHECKPOINT_NAME_SIZE) return false;
+	memset(_record, 0, CHECKPOINT_NAME_SIZE);
+	memcpy(_record, _name.data(), _name.size());
+	return true;
+}
+
+template<typename T>
+string Checkpointer<T>::ReadName(const char* _record)
+{
+	return string(_record, strnlen(_record, CHECKPOINT_NAME_SIZE));
+}
+
+template<typename T>
+bool Checkpointer<T>::Checkpoint()
+{
+	const map<string, Position<T>>& _positions = positionService->GetPositions();
+	const map<string, PV01<T>>& _pv01s = riskService->GetPV01s();
+	long long _positionCount = 0;
+	for (auto& p : _positions) _positionCount += p.second.GetPositions().size();
+
+	image.resize(sizeof(CheckpointHeader) + _positionCount * sizeof(CheckpointPosition) + _pv01s.size() * sizeof(CheckpointPV01));
+	CheckpointHeader* _header = (CheckpointHeader*)image.data();
+	memcpy(_header->magic, "TSCP", 4);
+	_header->version = CHECKPOINT_VERSION;
+	_header->tradeCount = tradeBookingConnector->GetTradeCount();
+	_header->positionCount = _positionCount;
+	_header->pv01Count = _pv01s.size();
+
+	CheckpointPosition* _position = (CheckpointPosition*)(_header + 1);
+	for (auto& p : _positions)
+	{
+		for (auto& b : p.second.GetPositions())
+		{
+			if (!CopyName(_position->productId, p.first) || !CopyName(_position->book, b.first)) return false;
+			_position->position = b.second;
+			_position++;
+		}
+	}
+	CheckpointPV01* _pv01 = (CheckpointPV01*)_position;
+	for (auto& p : _pv01s)
+	{
+		if (!CopyName(_pv01->productId, p.first)) return false;
+		_pv01->pv01 = p.second.GetPV01();
+		_pv01->quantity = p.second.GetQuantity();
+		_pv01++;
+	}
+
+	writer.Write(image);
+	return true;
+}
+
+template<typename T>
+bool Checkpointer<T>::Load()
+{
+	MappedFile _file;
+	if (!_file.Open(path) || _file.GetSize() < sizeof(CheckpointHeader)) return false;
+	const CheckpointHeader* _header = (const CheckpointHeader*)_file.GetData();
+	if (memcmp(_header->magic, "TSCP", 4) != 0 || _header->version != CHECKPOINT_VERSION) return false;
+	if (_header->positionCount < 0 || _header->pv01Count < 0) return false;
+	size_t _size = sizeof(CheckpointHeader) + _header->positionCount * sizeof(CheckpointPosition) + _header->pv01Count * sizeof(CheckpointPV01);
+	if (_file.GetSize() != _size) return false;
+
+	// Records of a product are contiguous, so each product is built up and put in once.
+	const CheckpointPosition* _position = (const CheckpointPosition*)(_header + 1);
+	const CheckpointPosition* _positionEnd = _position + _header->positionCount;
+	while (_position != _positionEnd)
+	{
+		string _productId = ReadName(_position->productId);
+		Position<T> _productPosition(GetBond(_productId));
+		for (; _position != _positionEnd && _productId == ReadName(_position->productId); _position++)
+		{
+			_productPosition.AddPosition(ReadName(_position->book), _position->position);
+		}
+		positionService->RestorePosition(_productPosition);
+	}
+
+	const CheckpointPV01* _pv01 = (const CheckpointPV01*)_positionEnd;
+	for (long long i = 0; i < _header->pv01Count; i++, _pv01++)
+	{
+		string _productId = ReadName(_pv01->productId);
+		PV01<T> _productPV01(GetBond(_productId), _pv01->pv01, _pv01->quantity);
+		riskService->OnMessage(_productPV01);
+	}
+
+	tradeBookingConnector->SkipTrades(_header->tradeCount);
+	return true;
+}
+
+template<typename T>
+void Checkpointer<T>::Flush()
+{
+	writer.Flush();
+}
+
+template<typename T>
+void Checkpointer<T>::ProcessUpdate()
+{
+	if (interval <= 0 || !tradeBookingConnector->IsSubscribing()) return;
+
+	// Trades held by the sequencer are counted as read but not booked yet.
+	if (++updateCount >= interval && tradeBookingConnector->IsSettled())
+	{
+		updateCount = 0;
+		Checkpoint();
+	}
+}
+
+/**
+* Checkpointer Listener subscribing data from Position Service to Checkpointer.
+* Type T is the product type.
+*/
+template<typename T>
+class CheckpointToPositionListener : public ServiceListener<Position<T>>
+{
+
+private:
+
+	Checkpointer<T>* service;
+
+public:
+
+	// Connector and Destructor
+	CheckpointToPositionListener(Checkpointer<T>* _service);
+	~CheckpointToPositionListener();
+
+	// Listener callback to process an add event to the Service
+	void ProcessAdd(Position<T>& _data);
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(Position<T>& _data);
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(Position<T>& _data);
+
+};
+
+template<typename T>
+CheckpointToPositionListener<T>::CheckpointToPositionListener(Checkpointer<T>* _service)
+{
+	service = _service;
+}
+
+template<typename T>
+CheckpointToPositionListener<T>::~CheckpointToPositionListener() {}
+
+template<typename T>
+void CheckpointToPositionListener<T>::ProcessAdd(Position<T>& _data)
+{
+	service->ProcessUpdate();
+}
+
+template<typename T>
+void CheckpointToPositionListener<T>::ProcessRemove(Position<T>& _data) {}
+
+template<typename T>
+void CheckpointToPositionListener<T>::ProcessUpdate(Position<T>& _data) {}
+
+#endif
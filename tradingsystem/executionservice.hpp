@@ -11,15 +11,24 @@
 #include <string>
 #include "soa.hpp"
 #include "algoexecutionservice.hpp"
+#include "matchingengine.hpp"
+#include "orderstore.hpp"
+#include "smartorderrouter.hpp"
+#include "fixconnector.hpp"
+#include "latencytracer.hpp"
 
 /**
 * Pre-declearations to avoid errors.
 */
 template<typename T>
 class ExecutionToAlgoExecutionListener;
+template<typename T>
+class ExecutionToMatchingEngineListener;
 
 /**
 * Service for executing orders on an exchange.
+* Fills are published as add events, and the quantity left on an order cancelled
+* or rejected by a venue, or refused by the order store, as a remove event.
 * Keyed on product identifier.
 * Type T is the product type.
 */
@@ -32,6 +41,15 @@ private:
 	map<string, ExecutionOrder<T>> executionOrders;
 	vector<ServiceListener<ExecutionOrder<T>>*> listeners;
 	ExecutionToAlgoExecutionListener<T>* listener;
+	ExecutionToMatchingEngineListener<T>* matchingEngineListener;
+	map<Market, MatchingEngine<T>*> matchingEngines;
+	map<Market, FixConnector<T>*> fixConnectors;
+	OrderStore<T> orderStore;
+	SmartOrderRouter<T>* smartOrderRouter;
+	unordered_map<string, string> routedOrders;
+
+	// Add an order to the store before it goes to a venue, or reject it if the store refuses it
+	bool StoreOrder(ExecutionOrder<T>& _executionOrder);
 
 public:
 
@@ -54,9 +72,30 @@ public:
 	// Get the listener of the service
 	ExecutionToAlgoExecutionListener<T>* GetListener();
 
+	// Route orders for the market of an engine to that engine instead of filling them in full
+	void AddMatchingEngine(MatchingEngine<T>* _matchingEngine);
+
+	// Route orders for a market over FIX to an acceptor instead of filling them in full
+	void AddFixConnector(Market _market, FixAcceptorSimulator* _acceptor);
+
+	// Split orders across venues with a smart order router instead of sending them to BROKERTEC
+	void SetSmartOrderRouter(SmartOrderRouter<T>* _smartOrderRouter);
+
 	// Execute an order on a market
 	void ExecuteOrder(ExecutionOrder<T>& _executionOrder);
 
+	// Execute an order on a given market
+	void ExecuteOrder(ExecutionOrder<T>& _executionOrder, Market _market);
+
+	// Cancel an order working on a given market
+	bool CancelOrder(const string& _orderId, Market _market);
+
+	// Process an execution event from a matching engine or FIX connector
+	void ProcessExecution(ExecutionEvent<T>& _executionEvent);
+
+	// Get the store of orders working on matching engines and FIX connections
+	const OrderStore<T>& GetOrderStore() const;
+
 };
 
 template<typename T>
@@ -65,6 +104,11 @@ ExecutionService<T>::ExecutionService()
 	executionOrders = map<string, ExecutionOrder<T>>();
 	listeners = vector<ServiceListener<ExecutionOrder<T>>*>();
 	listener = new ExecutionToAlgoExecutionListener<T>(this);
+	matchingEngineListener = new ExecutionToMatchingEngineListener<T>(this);
+	matchingEngines = map<Market, MatchingEngine<T>*>();
+	fixConnectors = map<Market, FixConnector<T>*>();
+	smartOrderRouter = nullptr;
+	routedOrders = unordered_map<string, string>();
 }
 
 template<typename T>
@@ -100,18 +144,172 @@ ExecutionToAlgoExecutionListener<T>* ExecutionService<T>::GetListener()
 	return listener;
 }
 
+template<typename T>
+void ExecutionService<T>::AddMatchingEngine(MatchingEngine<T>* _matchingEngine)
+{
+	matchingEngines[_matchingEngine->GetMarket()] = _matchingEngine;
+	_matchingEngine->AddListener(matchingEngineListener);
+}
+
+template<typename T>
+void ExecutionService<T>::AddFixConnector(Market _market, FixAcceptorSimulator* _acceptor)
+{
+	fixConnectors[_market] = new FixConnector<T>(this, _market, _acceptor);
+}
+
+template<typename T>
+void ExecutionService<T>::SetSmartOrderRouter(SmartOrderRouter<T>* _smartOrderRouter)
+{
+	smartOrderRouter = _smartOrderRouter;
+}
+
 template<typename T>
 void ExecutionService<T>::ExecuteOrder(ExecutionOrder<T>& _executionOrder)
+{
+	if (!smartOrderRouter)
+	{
+		ExecuteOrder(_executionOrder, BROKERTEC);
+		return;
+	}
+
+	RoutingDecision _decision = smartOrderRouter->RouteOrder(_executionOrder);
+	long _quantity = _executionOrder.GetVisibleQuantity() + _executionOrder.GetHiddenQuantity();
+	for (int i = 0; i < VENUE_COUNT; i++)
+	{
+		Market _market = (Market)i;
+		long _venueQuantity = _decision.GetQuantity(_market);
+		if (_venueQuantity <= 0) continue;
+		if (_venueQuantity == _quantity)
+		{
+			ExecuteOrder(_executionOrder, _market);
+			return;
+		}
+
+		// Orders split over matching engines need an ID per venue, and their fills are
+		// reported under the ID of the order they were split from.
+		string _orderId = _executionOrder.GetOrderId();
+		if (matchingEngines.find(_market) != matchingEngines.end() || fixConnectors.find(_market) != fixConnectors.end())
+		{
+			_orderId += "." + to_string(i);
+			routedOrders[_orderId] = _executionOrder.GetOrderId();
+		}
+		ExecutionOrder<T> _venueOrder(_executionOrder.GetProduct(), _executionOrder.GetPricingSide(), _orderId, _executionOrder.GetOrderType(), _executionOrder.GetPrice(), _venueQuantity, 0, _executionOrder.GetParentOrderId(), _executionOrder.IsChildOrder());
+		ExecuteOrder(_venueOrder, _market);
+	}
+}
+
+template<typename T>
+void ExecutionService<T>::ExecuteOrder(ExecutionOrder<T>& _executionOrder, Market _market)
 {
 	string _productId = _executionOrder.GetProduct().GetProductId();
 	executionOrders[_productId] = _executionOrder;
 
+	TRACE_STAGE(ORDER_SENT);
+	auto _engineIter = matchingEngines.find(_market);
+	if (_engineIter != matchingEngines.end())
+	{
+		if (StoreOrder(_executionOrder)) _engineIter->second->SubmitOrder(_executionOrder);
+		return;
+	}
+	auto _fixIter = fixConnectors.find(_market);
+	if (_fixIter != fixConnectors.end())
+	{
+		if (StoreOrder(_executionOrder)) _fixIter->second->Publish(_executionOrder);
+		return;
+	}
+
 	for (auto& l : listeners)
 	{
 		l->ProcessAdd(_executionOrder);
 	}
 }
 
+template<typename T>
+bool ExecutionService<T>::StoreOrder(ExecutionOrder<T>& _executionOrder)
+{
+	if (orderStore.AddOrder(_executionOrder) >= 0) return true;
+
+	// An order the store cannot track would have its acks and fills dropped, so it never
+	// reaches the venue, and is reported as a reject of its whole quantity instead.
+	string _orderId = _executionOrder.GetOrderId();
+	auto _routedIter = routedOrders.find(_orderId);
+	if (_routedIter != routedOrders.end())
+	{
+		_orderId = _routedIter->second;
+		routedOrders.erase(_routedIter);
+	}
+	ExecutionOrder<T> _reject(_executionOrder.GetProduct(), _executionOrder.GetPricingSide(), _orderId, _executionOrder.GetOrderType(), _executionOrder.GetPrice(), _executionOrder.GetVisibleQuantity() + _executionOrder.GetHiddenQuantity(), 0, _executionOrder.GetParentOrderId(), _executionOrder.IsChildOrder());
+	for (auto& l : listeners)
+	{
+		l->ProcessRemove(_reject);
+	}
+	return false;
+}
+
+template<typename T>
+bool ExecutionService<T>::CancelOrder(const string& _orderId, Market _market)
+{
+	long _slot = orderStore.FindOrder(_orderId);
+	if (_slot < 0) return false;
+
+	auto _engineIter = matchingEngines.find(_market);
+	if (_engineIter != matchingEngines.end()) return _engineIter->second->CancelOrder(_orderId);
+	auto _fixIter = fixConnectors.find(_market);
+	if (_fixIter == fixConnectors.end()) return false;
+	ExecutionOrder<T> _order(orderStore.GetProduct(_slot), orderStore.GetPricingSide(_slot), _orderId, orderStore.GetOrderType(_slot), orderStore.GetPrice(_slot), orderStore.GetLeavesQuantity(_slot), 0, orderStore.GetParentOrderId(_slot), orderStore.IsChildOrder(_slot));
+	return _fixIter->second->CancelOrder(_order);
+}
+
+template<typename T>
+void ExecutionService<T>::ProcessExecution(ExecutionEvent<T>& _executionEvent)
+{
+	const string& _orderId = _executionEvent.GetOrderId();
+	long _slot = orderStore.FindOrder(_orderId);
+	if (_slot < 0) return;
+
+	ExecutionEventType _type = _executionEvent.GetType();
+	if (_type == EXECUTION_ACKED)
+	{
+		orderStore.AckOrder(_orderId);
+		return;
+	}
+	auto _routedIter = routedOrders.find(_orderId);
+	const string& _reportOrderId = _routedIter != routedOrders.end() ? _routedIter->second : _orderId;
+	if (_type == EXECUTION_CANCELLED || _type == EXECUTION_REJECTED)
+	{
+		// The quantity left unfilled goes downstream as a remove event, so a parent can work it again.
+		ExecutionOrder<T> _cancel(orderStore.GetProduct(_slot), orderStore.GetPricingSide(_slot), _reportOrderId, orderStore.GetOrderType(_slot), orderStore.GetPrice(_slot), orderStore.GetLeavesQuantity(_slot), 0, orderStore.GetParentOrderId(_slot), orderStore.IsChildOrder(_slot));
+		orderStore.CancelOrder(_orderId);
+		orderStore.ReleaseOrder(_orderId);
+		if (_routedIter != routedOrders.end()) routedOrders.erase(_routedIter);
+		for (auto& l : listeners)
+		{
+			l->ProcessRemove(_cancel);
+		}
+		return;
+	}
+
+	// Each fill goes downstream as an execution of the filled quantity at the fill price.
+	// The store is settled before listeners run, since they may submit further orders.
+	ExecutionOrder<T> _fill(orderStore.GetProduct(_slot), orderStore.GetPricingSide(_slot), _reportOrderId, orderStore.GetOrderType(_slot), _executionEvent.GetPrice(), _executionEvent.GetQuantity(), 0, orderStore.GetParentOrderId(_slot), orderStore.IsChildOrder(_slot));
+	orderStore.FillOrder(_orderId, _executionEvent.GetQuantity());
+	if (_type == EXECUTION_FILLED || orderStore.GetState(_slot) == ORDER_FILLED)
+	{
+		orderStore.ReleaseOrder(_orderId);
+		if (_routedIter != routedOrders.end()) routedOrders.erase(_routedIter);
+	}
+	for (auto& l : listeners)
+	{
+		l->ProcessAdd(_fill);
+	}
+}
+
+template<typename T>
+const OrderStore<T>& ExecutionService<T>::GetOrderStore() const
+{
+	return orderStore;
+}
+
 /**
 * Execution Service Listener subscribing data from Algo Execution Service to Execution Service.
 * Type T is the product type.
@@ -164,4 +362,54 @@ void ExecutionToAlgoExecutionListener<T>::ProcessRemove(AlgoExecution<T>& _data)
 template<typename T>
 void ExecutionToAlgoExecutionListener<T>::ProcessUpdate(AlgoExecution<T>& _data) {}
 
+/**
+* Execution Service Listener subscribing execution events from a Matching Engine to Execution Service.
+* Type T is the product type.
+*/
+template<typename T>
+class ExecutionToMatchingEngineListener : public ServiceListener<ExecutionEvent<T>>
+{
+
+private:
+
+	ExecutionService<T>* service;
+
+public:
+
+	// Connector and Destructor
+	ExecutionToMatchingEngineListener(ExecutionService<T>* _service);
+	~ExecutionToMatchingEngineListener();
+
+	// Listener callback to process an add event to the Service
+	void ProcessAdd(ExecutionEvent<T>& _data);
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(ExecutionEvent<T>& _data);
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(ExecutionEvent<T>& _data);
+
+};
+
+template<typename T>
+ExecutionToMatchingEngineListener<T>::ExecutionToMatchingEngineListener(ExecutionService<T>* _service)
+{
+	service = _service;
+}
+
+template<typename T>
+ExecutionToMatchingEngineListener<T>::~ExecutionToMatchingEngineListener() {}
+
+template<typename T>
+void ExecutionToMatchingEngineListener<T>::ProcessAdd(ExecutionEvent<T>& _data)
+{
+	service->ProcessExecution(_data);
+}
+
+template<typename T>
+void ExecutionToMatchingEngineListener<T>::ProcessRemove(ExecutionEvent<T>& _data) {}
+
+template<typename T>
+void ExecutionToMatchingEngineListener<T>::ProcessUpdate(ExecutionEvent<T>& _data) {}
+
 #endif
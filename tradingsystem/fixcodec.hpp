@@ -0,0 +1,633 @@
+/**
+* fixcodec.hpp
+* Defines the FIX 4.4 encoder and decoder for order entry and execution reports.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef FIX_CODEC_HPP
+#define FIX_CODEC_HPP
+
+#include <string>
+#include <array>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+
+using namespace std;
+
+// Field delimiter of FIX messages
+const char FIX_SOH = '\x01';
+
+/**
+* Constant run of FIX text with its byte sum, so it can be copied into a message
+* and added to the checksum without going over its bytes again.
+*/
+class FixPrefix
+{
+
+public:
+
+	// ctor for a FIX prefix
+	FixPrefix() = default;
+	FixPrefix(const string& _text);
+
+	// Get the text
+	const char* GetText() const;
+
+	// Get the length of the text
+	size_t GetLength() const;
+
+	// Get the sum of the bytes of the text
+	unsigned int GetSum() const;
+
+private:
+
+	array<char, 64> text;
+	size_t length;
+	unsigned int sum;
+
+};
+
+FixPrefix::FixPrefix(const string& _text)
+{
+	length = min(_text.size(), text.size());
+	memcpy(text.data(), _text.data(), length);
+	sum = 0;
+	for (size_t i = 0; i < length; i++) sum += (unsigned char)text[i];
+}
+
+const char* FixPrefix::GetText() const
+{
+	return text.data();
+}
+
+size_t FixPrefix::GetLength() const
+{
+	return length;
+}
+
+unsigned int FixPrefix::GetSum() const
+{
+	return sum;
+}
+
+/**
+* FIX 4.4 encoder writing messages into a buffer it owns.
+* The message type, the session identifiers and the tag of the sequence number
+* are one precomputed prefix per message type, and every other tag is a
+* precomputed prefix too, so encoding copies constant runs and writes values
+* straight into the buffer. The body is written first, after room kept for the
+* begin string and body length, which are then put right in front of it.
+* Every append checks the room left in the buffer, keeping enough for the
+* checksum, and a message that would not fit fails to encode.
+* A message stays valid until the next one is encoded.
+*/
+class FixEncoder
+{
+
+public:
+
+	// ctor for a FIX encoder
+	FixEncoder(const string& _senderCompId, const string& _targetCompId);
+
+	// Encode a NewOrderSingle (35=D), with the price as Price(44) on a limit order and as StopPx(99) on a stop order, and get whether it fit
+	bool EncodeNewOrderSingle(const char* _clOrdId, size_t _clOrdIdLength, const char* _symbol, size_t _symbolLength, char _side, char _ordType, char _timeInForce, double _price, long _quantity);
+
+	// Encode an OrderCancelRequest (35=F), and get whether it fit
+	bool EncodeOrderCancelRequest(const char* _clOrdId, size_t _clOrdIdLength, const char* _origClOrdId, size_t _origClOrdIdLength, const char* _symbol, size_t _symbolLength, char _side, long _quantity);
+
+	// Encode an ExecutionReport (35=8), and get whether it fit
+	bool EncodeExecutionReport(const char* _orderId, size_t _orderIdLength, const char* _clOrdId, size_t _clOrdIdLength, const char* _origClOrdId, size_t _origClOrdIdLength, long _execId, char _execType, char _ordStatus, const char* _symbol, size_t _symbolLength, char _side, double _lastPx, long _lastQty, long _leavesQty, long _cumQty, double _avgPx);
+
+	// Get the last encoded message
+	const char* GetMessage() const;
+
+	// Get the length of the last encoded message
+	size_t GetLength() const;
+
+	// Get the sequence number of the last encoded message
+	long GetSequenceNumber() const;
+
+private:
+
+	enum FixTag { CL_ORD_ID, ORIG_CL_ORD_ID, ORDER_ID, EXEC_ID, EXEC_TYPE, ORD_STATUS, SYMBOL, SIDE, ORD_TYPE, TIME_IN_FORCE, PRICE, STOP_PX, ORDER_QTY, LAST_PX, LAST_QTY, LEAVES_QTY, CUM_QTY, AVG_PX, TRANSACT_TIME, SENDING_TIME, FIX_TAG_COUNT };
+
+	static const size_t BUFFER_SIZE = 1024;
+	static const size_t HEADER_SIZE = 32;
+	static const size_t TRAILER_SIZE = 7;
+
+	array<char, BUFFER_SIZE> buffer;
+	char* cursor;
+	char* limit;
+	bool overflow;
+	unsigned int sum;
+	size_t start;
+	size_t length;
+	long sequenceNumber;
+
+	FixPrefix newOrderSinglePrefix;
+	FixPrefix orderCancelRequestPrefix;
+	FixPrefix executionReportPrefix;
+	array<FixPrefix, FIX_TAG_COUNT> tagPrefixes;
+
+	long long timestampSecond;
+	array<char, 18> timestampText;
+
+	// Start a message body with its type prefix
+	void Begin(const FixPrefix& _prefix);
+
+	// Put the header in front of the body and append the checksum, and get whether the message fit
+	bool End();
+
+	// Check there is room for a number of characters, marking the message as overflowing if not
+	bool HasRoom(size_t _length);
+
+	// Append a constant prefix
+	void Append(const FixPrefix& _prefix);
+
+	// Append characters
+	void Append(const char* _text, size_t _length);
+
+	// Append a character
+	void Append(char _character);
+
+	// Append an integer
+	void Append(long long _value);
+
+	// Append a price with up to eight decimals
+	void AppendPrice(double _price);
+
+	// Append the current UTC time as YYYYMMDD-HH:MM:SS.sss
+	void AppendTimestamp();
+
+	// Append a string field
+	void AppendField(FixTag _tag, const char* _value, size_t _length);
+
+	// Append a character field
+	void AppendField(FixTag _tag, char _value);
+
+	// Append an integer field
+	void AppendField(FixTag _tag, long long _value);
+
+	// Append a price field
+	void AppendPriceField(FixTag _tag, double _price);
+
+};
+
+FixEncoder::FixEncoder(const string& _senderCompId, const string& _targetCompId)
+{
+	string _session = string(1, FIX_SOH) + "49=" + _senderCompId + FIX_SOH + "56=" + _targetCompId + FIX_SOH + "34=";
+	newOrderSinglePrefix = FixPrefix("35=D" + _session);
+	orderCancelRequestPrefix = FixPrefix("35=F" + _session);
+	executionReportPrefix = FixPrefix("35=8" + _session);
+
+	const char* _tags[] = { "11=", "41=", "37=", "17=", "150=", "39=", "55=", "54=", "40=", "59=", "44=", "99=", "38=", "31=", "32=", "151=", "14=", "6=", "60=", "52=" };
+	for (int i = 0; i < FIX_TAG_COUNT; i++)
+	{
+		tagPrefixes[i] = FixPrefix(_tags[i]);
+	}
+
+	cursor = buffer.data();
+	limit = buffer.data() + BUFFER_SIZE - TRAILER_SIZE;
+	overflow = false;
+	sum = 0;
+	start = 0;
+	length = 0;
+	sequenceNumber = 0;
+	timestampSecond = -1;
+}
+
+void FixEncoder::Begin(const FixPrefix& _prefix)
+{
+	cursor = buffer.data() + HEADER_SIZE;
+	overflow = false;
+	sum = 0;
+	Append(_prefix);
+	Append((long long)++sequenceNumber);
+	Append(FIX_SOH);
+	Append(tagPrefixes[SENDING_TIME]);
+	AppendTimestamp();
+	Append(FIX_SOH);
+}
+
+bool FixEncoder::End()
+{
+	if (overflow)
+	{
+		start = 0;
+		length = 0;
+		return false;
+	}
+
+	size_t _bodyLength = cursor - (buffer.data() + HEADER_SIZE);
+	char* _bodyEnd = cursor;
+
+	// Write "8=FIX.4.4|9=<length>|" backwards so that it ends where the body starts.
+	char* _header = buffer.data() + HEADER_SIZE;
+	*--_header = FIX_SOH;
+	do
+	{
+		*--_header = (char)('0' + _bodyLength % 10);
+		_bodyLength /= 10;
+	} while (_bodyLength > 0);
+	static const char _beginString[] = "8=FIX.4.4\x01" "9=";
+	_header -= sizeof(_beginString) - 1;
+	memcpy(_header, _beginString, sizeof(_beginString) - 1);
+	for (char* c = _header; c < buffer.data() + HEADER_SIZE; c++) sum += (unsigned char)*c;
+
+	cursor = _bodyEnd;
+	unsigned int _checksum = sum % 256;
+	static const char _trailer[] = "10=";
+	memcpy(cursor, _trailer, 3);
+	cursor[3] = (char)('0' + _checksum / 100);
+	cursor[4] = (char)('0' + _checksum / 10 % 10);
+	cursor[5] = (char)('0' + _checksum % 10);
+	cursor[6] = FIX_SOH;
+	cursor += 7;
+
+	start = _header - buffer.data();
+	length = cursor - _header;
+	return true;
+}
+
+bool FixEncoder::HasRoom(size_t _length)
+{
+	if (overflow || (size_t)(limit - cursor) < _length) overflow = true;
+	return !overflow;
+}
+
+void FixEncoder::Append(const FixPrefix& _prefix)
+{
+	if (!HasRoom(_prefix.GetLength())) return;
+	memcpy(cursor, _prefix.GetText(), _prefix.GetLength());
+	cursor += _prefix.GetLength();
+	sum += _prefix.GetSum();
+}
+
+void FixEncoder::Append(const char* _text, size_t _length)
+{
+	if (!HasRoom(_length)) return;
+	for (size_t i = 0; i < _length; i++)
+	{
+		cursor[i] = _text[i];
+		sum += (unsigned char)_text[i];
+	}
+	cursor += _length;
+}
+
+void FixEncoder::Append(char _character)
+{
+	if (!HasRoom(1)) return;
+	*cursor++ = _character;
+	sum += (unsigned char)_character;
+}
+
+void FixEncoder::Append(long long _value)
+{
+	char _digits[24];
+	int _count = 0;
+	bool _isNegative = _value < 0;
+	unsigned long long _magnitude = _isNegative ? 0ULL - (unsigned long long)_value : (unsigned long long)_value;
+	do
+	{
+		_digits[_count++] = (char)('0' + _magnitude % 10);
+		_magnitude /= 10;
+	} while (_magnitude > 0);
+	if (_isNegative) Append('-');
+	while (_count > 0) Append(_digits[--_count]);
+}
+
+void FixEncoder::AppendPrice(double _price)
+{
+	// Treasury prices are in 1/256ths, which need eight decimals to be exact.
+	long long _scaled = llround(_price * 100000000.0);
+	if (_scaled < 0)
+	{
+		Append('-');
+		_scaled = -_scaled;
+	}
+	Append(_scaled / 100000000);
+	long long _fraction = _scaled % 100000000;
+	if (_fraction == 0) return;
+
+	char _digits[8];
+	int _count = 8;
+	for (int i = 7; i >= 0; i--)
+	{
+		_digits[i] = (char)('0' + _fraction % 10);
+		_fraction /= 10;
+	}
+	while (_digits[_count - 1] == '0') _count--;
+	Append('.');
+	Append(_digits, _count);
+}
+
+void FixEncoder::AppendTimestamp()
+{
+	long long _milliseconds = chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+	long long _second = _milliseconds / 1000;
+	if (_second != timestampSecond)
+	{
+		// The date and time of day only change once a second, so they are formatted once a second.
+		time_t _time = (time_t)_second;
+		tm _tm;
+#ifdef _MSC_VER
+		gmtime_s(&_tm, &_time);
+#else
+		gmtime_r(&_time, &_tm);
+#endif
+		strftime(timestampText.data(), timestampText.size(), "%Y%m%d-%H:%M:%S", &_tm);
+		timestampSecond = _second;
+	}
+	Append(timestampText.data(), timestampText.size() - 1);
+	int _millisecond = (int)(_milliseconds % 1000);
+	Append('.');
+	Append((char)('0' + _millisecond / 100));
+	Append((char)('0' + _millisecond / 10 % 10));
+	Append((char)('0' + _millisecond % 10));
+}
+
+void FixEncoder::AppendField(FixTag _tag, const char* _value, size_t _length)
+{
+	Append(tagPrefixes[_tag]);
+	Append(_value, _length);
+	Append(FIX_SOH);
+}
+
+void FixEncoder::AppendField(FixTag _tag, char _value)
+{
+	Append(tagPrefixes[_tag]);
+	Append(_value);
+	Append(FIX_SOH);
+}
+
+void FixEncoder::AppendField(FixTag _tag, long long _value)
+{
+	Append(tagPrefixes[_tag]);
+	Append(_value);
+	Append(FIX_SOH);
+}
+
+void FixEncoder::AppendPriceField(FixTag _tag, double _price)
+{
+	Append(tagPrefixes[_tag]);
+	AppendPrice(_price);
+	Append(FIX_SOH);
+}
+
+bool FixEncoder::EncodeNewOrderSingle(const char* _clOrdId, size_t _clOrdIdLength, const char* _symbol, size_t _symbolLength, char _side, char _ordType, char _timeInForce, double _price, long _quantity)
+{
+	Begin(newOrderSinglePrefix);
+	AppendField(CL_ORD_ID, _clOrdId, _clOrdIdLength);
+	AppendField(SYMBOL, _symbol, _symbolLength);
+	AppendField(SIDE, _side);
+	Append(tagPrefixes[TRANSACT_TIME]);
+	AppendTimestamp();
+	Append(FIX_SOH);
+	AppendField(ORDER_QTY, (long long)_quantity);
+	AppendField(ORD_TYPE, _ordType);
+
+	// A market order goes at any price, and a stop order is triggered at its stop price.
+	if (_ordType == '2') AppendPriceField(PRICE, _price);
+	else if (_ordType == '3') AppendPriceField(STOP_PX, _price);
+	if (_timeInForce) AppendField(TIME_IN_FORCE, _timeInForce);
+	return End();
+}
+
+bool FixEncoder::EncodeOrderCancelRequest(const char* _clOrdId, size_t _clOrdIdLength, const char* _origClOrdId, size_t _origClOrdIdLength, const char* _symbol, size_t _symbolLength, char _side, long _quantity)
+{
+	Begin(orderCancelRequestPrefix);
+	AppendField(ORIG_CL_ORD_ID, _origClOrdId, _origClOrdIdLength);
+	AppendField(CL_ORD_ID, _clOrdId, _clOrdIdLength);
+	AppendField(SYMBOL, _symbol, _symbolLength);
+	AppendField(SIDE, _side);
+	Append(tagPrefixes[TRANSACT_TIME]);
+	AppendTimestamp();
+	Append(FIX_SOH);
+	AppendField(ORDER_QTY, (long long)_quantity);
+	return End();
+}
+
+bool FixEncoder::EncodeExecutionReport(const char* _orderId, size_t _orderIdLength, const char* _clOrdId, size_t _clOrdIdLength, const char* _origClOrdId, size_t _origClOrdIdLength, long _execId, char _execType, char _ordStatus, const char* _symbol, size_t _symbolLength, char _side, double _lastPx, long _lastQty, long _leavesQty, long _cumQty, double _avgPx)
+{
+	Begin(executionReportPrefix);
+	AppendField(ORDER_ID, _orderId, _orderIdLength);
+	AppendField(CL_ORD_ID, _clOrdId, _clOrdIdLength);
+	if (_origClOrdIdLength > 0) AppendField(ORIG_CL_ORD_ID, _origClOrdId, _origClOrdIdLength);
+	AppendField(EXEC_ID, (long long)_execId);
+	AppendField(EXEC_TYPE, _execType);
+	AppendField(ORD_STATUS, _ordStatus);
+	AppendField(SYMBOL, _symbol, _symbolLength);
+	AppendField(SIDE, _side);
+	if (_lastQty > 0)
+	{
+		AppendPriceField(LAST_PX, _lastPx);
+		AppendField(LAST_QTY, (long long)_lastQty);
+	}
+	AppendField(LEAVES_QTY, (long long)_leavesQty);
+	AppendField(CUM_QTY, (long long)_cumQty);
+	AppendPriceField(AVG_PX, _avgPx);
+	return End();
+}
+
+const char* FixEncoder::GetMessage() const
+{
+	return buffer.data() + start;
+}
+
+size_t FixEncoder::GetLength() const
+{
+	return length;
+}
+
+long FixEncoder::GetSequenceNumber() const
+{
+	return sequenceNumber;
+}
+
+/**
+* FIX field seen in place in a received message.
+*/
+class FixField
+{
+
+public:
+
+	// ctor for a FIX field
+	FixField() = default;
+	FixField(int _tag, const char* _value, size_t _length);
+
+	// Get the tag
+	int GetTag() const;
+
+	// Get the value, which is not null terminated
+	const char* GetValue() const;
+
+	// Get the length of the value
+	size_t GetLength() const;
+
+	// Does the value equal a string?
+	bool Equals(const char* _text) const;
+
+	// Get the value as an integer
+	long long GetInt() const;
+
+	// Get the value as a price
+	double GetDouble() const;
+
+	// Get the first character of the value
+	char GetChar() const;
+
+private:
+
+	int tag;
+	const char* value;
+	size_t length;
+
+};
+
+FixField::FixField(int _tag, const char* _value, size_t _length) :
+	tag(_tag), value(_value), length(_length) {}
+
+int FixField::GetTag() const
+{
+	return tag;
+}
+
+const char* FixField::GetValue() const
+{
+	return value;
+}
+
+size_t FixField::GetLength() const
+{
+	return length;
+}
+
+bool FixField::Equals(const char* _text) const
+{
+	return strlen(_text) == length && memcmp(value, _text, length) == 0;
+}
+
+long long FixField::GetInt() const
+{
+	long long _value = 0;
+	size_t i = 0;
+	bool _isNegative = length > 0 && value[0] == '-';
+	if (_isNegative) i++;
+	for (; i < length; i++) _value = _value * 10 + (value[i] - '0');
+	return _isNegative ? -_value : _value;
+}
+
+double FixField::GetDouble() const
+{
+	// The value always ends at a delimiter, which stops the conversion.
+	return strtod(value, nullptr);
+}
+
+char FixField::GetChar() const
+{
+	return length > 0 ? value[0] : '\0';
+}
+
+/**
+* FIX 4.4 decoder splitting a received message into fields in place.
+* Fields point into the received bytes, which must outlive the decoded message.
+* Decoding checks that the message starts with the begin string, the body length
+* and the message type, in that order, and checks the body length and the checksum.
+*/
+class FixDecoder
+{
+
+public:
+
+	// Most fields a decoded message keeps
+	static const int MAX_FIELDS = 64;
+
+	// ctor for a FIX decoder
+	FixDecoder();
+
+	// Decode a message, returning false if it is malformed
+	bool Decode(const char* _message, size_t _length);
+
+	// Get the message type
+	const FixField& GetMsgType() const;
+
+	// Get a field by tag, or nullptr if the message does not have it
+	const FixField* GetField(int _tag) const;
+
+	// Get the number of fields
+	int GetFieldCount() const;
+
+private:
+
+	array<FixField, MAX_FIELDS> fields;
+	int count;
+
+};
+
+FixDecoder::FixDecoder()
+{
+	count = 0;
+}
+
+bool FixDecoder::Decode(const char* _message, size_t _length)
+{
+	count = 0;
+	unsigned int _sum = 0;
+	size_t _bodyStart = 0;
+	size_t i = 0;
+	while (i < _length)
+	{
+		size_t _fieldStart = i;
+		int _tag = 0;
+		while (i < _length && _message[i] != '=')
+		{
+			_tag = _tag * 10 + (_message[i] - '0');
+			i++;
+		}
+		if (i >= _length) return false;
+		size_t _valueStart = ++i;
+		while (i < _length && _message[i] != FIX_SOH) i++;
+		if (i >= _length) return false;
+
+		if (_tag == 10)
+		{
+			FixField _checksum(_tag, _message + _valueStart, i - _valueStart);
+			return (int)(_sum % 256) == _checksum.GetInt() && count > 2 && fields[1].GetInt() == (long long)(_fieldStart - _bodyStart);
+		}
+		for (size_t c = _fieldStart; c <= i; c++) _sum += (unsigned char)_message[c];
+		if (count < MAX_FIELDS) fields[count++] = FixField(_tag, _message + _valueStart, i - _valueStart);
+		if (count == 1 && (_tag != 8 || !fields[0].Equals("FIX.4.4"))) return false;
+		if (count == 2 && _tag != 9) return false;
+		if (count == 3 && _tag != 35) return false;
+		if (count == 2) _bodyStart = i + 1;
+		i++;
+	}
+	return false;
+}
+
+const FixField& FixDecoder::GetMsgType() const
+{
+	return fields[2];
+}
+
+const FixField* FixDecoder::GetField(int _tag) const
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (fields[i].GetTag() == _tag) return &fields[i];
+	}
+	return nullptr;
+}
+
+int FixDecoder::GetFieldCount() const
+{
+	return count;
+}
+
+#endif
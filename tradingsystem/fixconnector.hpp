@@ -0,0 +1,448 @@
+/**
+* fixconnector.hpp
+* Defines the FIX connector of the execution service and a loopback FIX acceptor simulator.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef FIX_CONNECTOR_HPP
+#define FIX_CONNECTOR_HPP
+
+#include <string>
+#include <unordered_map>
+#include "soa.hpp"
+#include "fixcodec.hpp"
+#include "algoexecutionservice.hpp"
+#include "matchingengine.hpp"
+
+using namespace std;
+
+/**
+* Side of a FIX session receiving raw messages from the other side.
+*/
+class FixMessageHandler
+{
+
+public:
+
+	// Destructor
+	virtual ~FixMessageHandler() {}
+
+	// Process a received message
+	virtual void ProcessMessage(const char* _message, size_t _length) = 0;
+
+};
+
+/**
+* FIX acceptor simulating a venue on the local loopback.
+* Messages are handed over in process as encoded bytes, so both sides go through
+* the full encode and decode path. Each NewOrderSingle is acknowledged and, when
+* orders fill, filled in full at its price; otherwise it stays open until an
+* OrderCancelRequest cancels it. Cancels of orders it does not know are ignored.
+* A limit order fills at its Price(44) and a stop order at its StopPx(99), as if
+* triggered at once. A market order fills at the market price set for its symbol,
+* and is rejected when there is none.
+* Every execution report also goes to the drop copy session, when one is connected.
+*/
+class FixAcceptorSimulator : public FixMessageHandler
+{
+
+public:
+
+	// ctor for a FIX acceptor simulator
+	FixAcceptorSimulator(const string& _senderCompId, const string& _targetCompId);
+
+	// Connect the initiator side of the session
+	void Connect(FixMessageHandler* _initiator);
+
+	// Connect a drop copy session receiving a copy of every execution report
+	void ConnectDropCopy(FixMessageHandler* _dropCopy);
+
+	// Set the price market orders of a symbol fill at
+	void SetMarketPrice(const string& _symbol, double _price);
+
+	// Set whether new orders fill at once or stay open
+	void SetFillOrders(bool _fillOrders);
+
+	// Get the number of open orders
+	long GetOpenOrderCount() const;
+
+	// Process a received message
+	void ProcessMessage(const char* _message, size_t _length);
+
+private:
+
+	struct OpenOrder
+	{
+		string orderId;
+		string symbol;
+		char side;
+		long quantity;
+		double price;
+	};
+
+	FixEncoder encoder;
+	FixDecoder decoder;
+	FixMessageHandler* initiator;
+	FixMessageHandler* dropCopy;
+	unordered_map<string, OpenOrder> openOrders;
+	unordered_map<string, double> marketPrices;
+	bool fillOrders;
+	long orderCount;
+	long execCount;
+
+	// Send the last encoded message to the initiator
+	void Send();
+
+};
+
+FixAcceptorSimulator::FixAcceptorSimulator(const string& _senderCompId, const string& _targetCompId) :
+	encoder(_senderCompId, _targetCompId)
+{
+	initiator = nullptr;
+	dropCopy = nullptr;
+	openOrders = unordered_map<string, OpenOrder>();
+	marketPrices = unordered_map<string, double>();
+	fillOrders = true;
+	orderCount = 0;
+	execCount = 0;
+}
+
+void FixAcceptorSimulator::Connect(FixMessageHandler* _initiator)
+{
+	initiator = _initiator;
+}
+
+void FixAcceptorSimulator::ConnectDropCopy(FixMessageHandler* _dropCopy)
+{
+	dropCopy = _dropCopy;
+}
+
+void FixAcceptorSimulator::SetMarketPrice(const string& _symbol, double _price)
+{
+	marketPrices[_symbol] = _price;
+}
+
+void FixAcceptorSimulator::SetFillOrders(bool _fillOrders)
+{
+	fillOrders = _fillOrders;
+}
+
+long FixAcceptorSimulator::GetOpenOrderCount() const
+{
+	return openOrders.size();
+}
+
+void FixAcceptorSimulator::Send()
+{
+	if (initiator) initiator->ProcessMessage(encoder.GetMessage(), encoder.GetLength());
+	if (dropCopy) dropCopy->ProcessMessage(encoder.GetMessage(), encoder.GetLength());
+}
+
+void FixAcceptorSimulator::ProcessMessage(const char* _message, size_t _length)
+{
+	if (!decoder.Decode(_message, _length)) return;
+	const FixField* _clOrdId = decoder.GetField(11);
+	const FixField* _symbol = decoder.GetField(55);
+	const FixField* _side = decoder.GetField(54);
+	const FixField* _quantity = decoder.GetField(38);
+	if (!_clOrdId || !_symbol || !_side || !_quantity) return;
+
+	if (decoder.GetMsgType().Equals("D"))
+	{
+		const FixField* _price = decoder.GetField(44);
+		if (!_price) _price = decoder.GetField(99);
+		OpenOrder _order;
+		_order.orderId = "O" + to_string(++orderCount);
+		_order.symbol = string(_symbol->GetValue(), _symbol->GetLength());
+		_order.side = _side->GetChar();
+		_order.quantity = _quantity->GetInt();
+		_order.price = _price ? _price->GetDouble() : 0.0;
+		string _clOrdIdText(_clOrdId->GetValue(), _clOrdId->GetLength());
+
+		auto _marketIter = marketPrices.find(_order.symbol);
+		if (!_price && _marketIter == marketPrices.end())
+		{
+			if (encoder.EncodeExecutionReport(_order.orderId.data(), _order.orderId.size(), _clOrdIdText.data(), _clOrdIdText.size(), "", 0, ++execCount, '8', '8', _order.symbol.data(), _order.symbol.size(), _order.side, 0.0, 0, 0, 0, 0.0)) Send();
+			return;
+		}
+		if (!_price) _order.price = _marketIter->second;
+
+		if (encoder.EncodeExecutionReport(_order.orderId.data(), _order.orderId.size(), _clOrdIdText.data(), _clOrdIdText.size(), "", 0, ++execCount, '0', '0', _order.symbol.data(), _order.symbol.size(), _order.side, 0.0, 0, _order.quantity, 0, 0.0)) Send();
+		if (fillOrders)
+		{
+			if (encoder.EncodeExecutionReport(_order.orderId.data(), _order.orderId.size(), _clOrdIdText.data(), _clOrdIdText.size(), "", 0, ++execCount, 'F', '2', _order.symbol.data(), _order.symbol.size(), _order.side, _order.price, _order.quantity, 0, _order.quantity, _order.price)) Send();
+		}
+		else
+		{
+			openOrders[_clOrdIdText] = _order;
+		}
+	}
+	else if (decoder.GetMsgType().Equals("F"))
+	{
+		const FixField* _origClOrdId = decoder.GetField(41);
+		if (!_origClOrdId) return;
+		auto _iter = openOrders.find(string(_origClOrdId->GetValue(), _origClOrdId->GetLength()));
+		if (_iter == openOrders.end()) return;
+		const OpenOrder& _order = _iter->second;
+		bool _isEncoded = encoder.EncodeExecutionReport(_order.orderId.data(), _order.orderId.size(), _clOrdId->GetValue(), _clOrdId->GetLength(), _iter->first.data(), _iter->first.size(), ++execCount, '4', '4', _order.symbol.data(), _order.symbol.size(), _order.side, 0.0, 0, 0, 0, 0.0);
+		openOrders.erase(_iter);
+		if (_isEncoded) Send();
+	}
+}
+
+/**
+* FIX drop copy session receiving a copy of every execution report a venue sends.
+* Reports are decoded in place and tallied per order, independently of the order
+* session, so the fills booked can be reconciled against what the venue reported.
+*/
+class FixDropCopy : public FixMessageHandler
+{
+
+public:
+
+	// ctor for a FIX drop copy session
+	FixDropCopy();
+
+	// Get the number of execution reports received
+	long GetReportCount() const;
+
+	// Get the quantity reported filled on an order
+	long GetFilledQuantity(const string& _clOrdId) const;
+
+	// Get the quantity reported filled on all orders
+	long GetTotalFilledQuantity() const;
+
+	// Process a received message
+	void ProcessMessage(const char* _message, size_t _length);
+
+private:
+
+	FixDecoder decoder;
+	unordered_map<string, long> filledQuantities;
+	long reportCount;
+	long totalFilledQuantity;
+
+};
+
+FixDropCopy::FixDropCopy()
+{
+	filledQuantities = unordered_map<string, long>();
+	reportCount = 0;
+	totalFilledQuantity = 0;
+}
+
+long FixDropCopy::GetReportCount() const
+{
+	return reportCount;
+}
+
+long FixDropCopy::GetFilledQuantity(const string& _clOrdId) const
+{
+	auto _iter = filledQuantities.find(_clOrdId);
+	return _iter == filledQuantities.end() ? 0 : _iter->second;
+}
+
+long FixDropCopy::GetTotalFilledQuantity() const
+{
+	return totalFilledQuantity;
+}
+
+void FixDropCopy::ProcessMessage(const char* _message, size_t _length)
+{
+	if (!decoder.Decode(_message, _length) || !decoder.GetMsgType().Equals("8")) return;
+	reportCount++;
+	const FixField* _clOrdId = decoder.GetField(11);
+	const FixField* _lastQty = decoder.GetField(32);
+	if (!_clOrdId || !_lastQty) return;
+	long _quantity = _lastQty->GetInt();
+	filledQuantities[string(_clOrdId->GetValue(), _clOrdId->GetLength())] += _quantity;
+	totalFilledQuantity += _quantity;
+}
+
+/**
+* Pre-declearations to avoid errors.
+*/
+template<typename T>
+class ExecutionService;
+
+/**
+* FIX Connector sending orders of Execution Service to a venue and reading back its execution reports.
+* Orders go out as NewOrderSingle and cancels as OrderCancelRequest, and each
+* ExecutionReport is decoded in place and handed to the service as an execution event.
+* An order too long to encode is rejected back to the service without being sent.
+* Type T is the product type.
+*/
+template<typename T>
+class FixConnector : public Connector<ExecutionOrder<T>>, public FixMessageHandler
+{
+
+private:
+
+	ExecutionService<T>* service;
+	Market market;
+	FixMessageHandler* acceptor;
+	FixEncoder encoder;
+	FixDecoder decoder;
+	unordered_map<string, T> products;
+
+	// Get the name of a market
+	static string GetMarketName(Market _market);
+
+public:
+
+	// Connector and Destructor
+	FixConnector(ExecutionService<T>* _service, Market _market, FixAcceptorSimulator* _acceptor);
+	~FixConnector();
+
+	// Get the market of the connector
+	Market GetMarket() const;
+
+	// Publish data to the Connector
+	void Publish(ExecutionOrder<T>& _data);
+
+	// Subscribe data from the Connector
+	void Subscribe(ifstream& _data);
+
+	// Send a cancel for an order, and get whether it was sent
+	bool CancelOrder(const ExecutionOrder<T>& _data);
+
+	// Process a received message
+	void ProcessMessage(const char* _message, size_t _length);
+
+};
+
+template<typename T>
+string FixConnector<T>::GetMarketName(Market _market)
+{
+	switch (_market)
+	{
+	case BROKERTEC:
+		return "BROKERTEC";
+	case ESPEED:
+		return "ESPEED";
+	case CME:
+		return "CME";
+	}
+	return "";
+}
+
+template<typename T>
+FixConnector<T>::FixConnector(ExecutionService<T>* _service, Market _market, FixAcceptorSimulator* _acceptor) :
+	encoder("TRADINGSYSTEM", GetMarketName(_market))
+{
+	service = _service;
+	market = _market;
+	acceptor = _acceptor;
+	products = unordered_map<string, T>();
+	_acceptor->Connect(this);
+}
+
+template<typename T>
+FixConnector<T>::~FixConnector() {}
+
+template<typename T>
+Market FixConnector<T>::GetMarket() const
+{
+	return market;
+}
+
+template<typename T>
+void FixConnector<T>::Publish(ExecutionOrder<T>& _data)
+{
+	const string& _productId = _data.GetProduct().GetProductId();
+	if (products.find(_productId) == products.end()) products.insert(make_pair(_productId, _data.GetProduct()));
+
+	// An order on the bid sells, an order on the offer buys.
+	char _side = _data.GetPricingSide() == BID ? '2' : '1';
+	char _ordType = '2';
+	char _timeInForce = '\0';
+	switch (_data.GetOrderType())
+	{
+	case MARKET:
+		_ordType = '1';
+		break;
+	case STOP:
+		_ordType = '3';
+		break;
+	case FOK:
+		_timeInForce = '4';
+		break;
+	case IOC:
+		_timeInForce = '3';
+		break;
+	default:
+		break;
+	}
+
+	const string& _orderId = _data.GetOrderId();
+	long _quantity = _data.GetVisibleQuantity() + _data.GetHiddenQuantity();
+	if (!encoder.EncodeNewOrderSingle(_orderId.data(), _orderId.size(), _productId.data(), _productId.size(), _side, _ordType, _timeInForce, _data.GetPrice(), _quantity))
+	{
+		ExecutionEvent<T> _reject(_data.GetProduct(), market, _orderId, EXECUTION_REJECTED, _data.GetPricingSide(), 0.0, 0, _quantity);
+		service->ProcessExecution(_reject);
+		return;
+	}
+	acceptor->ProcessMessage(encoder.GetMessage(), encoder.GetLength());
+}
+
+template<typename T>
+void FixConnector<T>::Subscribe(ifstream& _data) {}
+
+template<typename T>
+bool FixConnector<T>::CancelOrder(const ExecutionOrder<T>& _data)
+{
+	const string& _productId = _data.GetProduct().GetProductId();
+	const string& _orderId = _data.GetOrderId();
+	string _clOrdId = GenerateId();
+	char _side = _data.GetPricingSide() == BID ? '2' : '1';
+	if (!encoder.EncodeOrderCancelRequest(_clOrdId.data(), _clOrdId.size(), _orderId.data(), _orderId.size(), _productId.data(), _productId.size(), _side, _data.GetVisibleQuantity() + _data.GetHiddenQuantity())) return false;
+	acceptor->ProcessMessage(encoder.GetMessage(), encoder.GetLength());
+	return true;
+}
+
+template<typename T>
+void FixConnector<T>::ProcessMessage(const char* _message, size_t _length)
+{
+	if (!decoder.Decode(_message, _length) || !decoder.GetMsgType().Equals("8")) return;
+	const FixField* _clOrdId = decoder.GetField(41);
+	if (!_clOrdId) _clOrdId = decoder.GetField(11);
+	const FixField* _symbol = decoder.GetField(55);
+	const FixField* _execType = decoder.GetField(150);
+	const FixField* _side = decoder.GetField(54);
+	if (!_clOrdId || !_symbol || !_execType || !_side) return;
+
+	auto _productIter = products.find(string(_symbol->GetValue(), _symbol->GetLength()));
+	if (_productIter == products.end()) return;
+
+	ExecutionEventType _type;
+	switch (_execType->GetChar())
+	{
+	case '0':
+		_type = EXECUTION_ACKED;
+		break;
+	case 'F':
+	{
+		const FixField* _ordStatus = decoder.GetField(39);
+		_type = _ordStatus && _ordStatus->GetChar() == '2' ? EXECUTION_FILLED : EXECUTION_PARTIALLY_FILLED;
+		break;
+	}
+	case '4':
+		_type = EXECUTION_CANCELLED;
+		break;
+	case '8':
+		_type = EXECUTION_REJECTED;
+		break;
+	default:
+		return;
+	}
+
+	const FixField* _lastPx = decoder.GetField(31);
+	const FixField* _lastQty = decoder.GetField(32);
+	const FixField* _leavesQty = decoder.GetField(151);
+	PricingSide _pricingSide = _side->GetChar() == '2' ? BID : OFFER;
+	ExecutionEvent<T> _event(_productIter->second, market, string(_clOrdId->GetValue(), _clOrdId->GetLength()), _type, _pricingSide, _lastPx ? _lastPx->GetDouble() : 0.0, _lastQty ? _lastQty->GetInt() : 0, _leavesQty ? _leavesQty->GetInt() : 0);
+	service->ProcessExecution(_event);
+}
+
+#endif
@@ -12,6 +12,7 @@
 #include <string>
 #include <chrono>
 #include "products.hpp"
+#include "idgenerator.hpp"
 
 using namespace std;
 using namespace chrono;
@@ -71,7 +72,7 @@ double ConvertPrice(string _stringPrice)
 	string _stringPrice8 = "";
 
 	int count = 0;
-	for (int i = 0; i < _stringPrice.size(); i++)
+	for (size_t i = 0; i < _stringPrice.size(); i++)
 	{
 		if (_stringPrice[i] == '-')
 		{
@@ -155,18 +156,18 @@ long GetMillisecond()
 	return _millisecCount;
 }
 
-// Generate random IDs.
+// Get the count of microseconds since epoch.
+long long GetEpochMicrosecond()
+{
+	auto _timePoint = system_clock::now();
+	return chrono::duration_cast<chrono::microseconds>(_timePoint.time_since_epoch()).count();
+}
+
+// Generate unique IDs.
 string GenerateId()
 {
-	string _base = "1234567890QWERTYUIOPASDFGHJKLZXCVBNM";
-	vector<double> _randoms = GenerateUniform(12, GetMillisecond());
-	string _id = "";
-	for (auto& r : _randoms)
-	{
-		int i = r * 36;
-		_id.push_back(_base[i]);
-	}
-	return _id;
+	static IdGenerator _generator;
+	return _generator.NextId();
 }
 
 #endif
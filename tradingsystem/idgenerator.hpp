@@ -0,0 +1,98 @@
+/**
+* idgenerator.hpp
+* Defines the generator of unique order identifiers.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef ID_GENERATOR_HPP
+#define ID_GENERATOR_HPP
+
+#include <string>
+#include <atomic>
+#include <chrono>
+
+using namespace std;
+
+/**
+* Generator of unique identifiers made of a session prefix and a sequence number.
+* The prefix is the session start time in microseconds since epoch and the sequence
+* is shared by all threads through an atomic counter, so identifiers increase on
+* every thread and never repeat across threads or restarts of the system.
+* Identifiers are ID_LENGTH characters of fixed-width base36, which sorts in issue
+* order and fits in the small string buffer, so generating one does not allocate.
+*/
+class IdGenerator
+{
+
+public:
+
+	// Number of characters in an identifier
+	static const int ID_LENGTH = 15;
+
+	// ctor for an ID generator
+	IdGenerator();
+
+	// Get the session prefix of the generator
+	long long GetSessionPrefix() const;
+
+	// Write the next identifier and a terminating null into a buffer of at least ID_LENGTH + 1 characters
+	void NextId(char* _buffer);
+
+	// Get the next identifier
+	string NextId();
+
+private:
+
+	static const int PREFIX_LENGTH = 10;
+	static const int SEQUENCE_LENGTH = 5;
+	static const long long SEQUENCE_BLOCK = 36LL * 36 * 36 * 36 * 36;
+
+	long long sessionPrefix;
+	atomic<long long> sequence;
+
+	// Write a number as fixed-width base36
+	static void Encode(long long _value, char* _buffer, int _length);
+
+};
+
+IdGenerator::IdGenerator()
+{
+	sessionPrefix = chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count();
+	sequence = 0;
+}
+
+long long IdGenerator::GetSessionPrefix() const
+{
+	return sessionPrefix;
+}
+
+void IdGenerator::Encode(long long _value, char* _buffer, int _length)
+{
+	static const char _digits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	for (int i = _length - 1; i >= 0; i--)
+	{
+		_buffer[i] = _digits[_value % 36];
+		_value /= 36;
+	}
+}
+
+void IdGenerator::NextId(char* _buffer)
+{
+	// Once the sequence digits run out the prefix moves on by one microsecond per block.
+	// A block takes far longer than a microsecond to issue, so the prefix never catches
+	// up with the start time of a later session.
+	long long _sequence = sequence.fetch_add(1, memory_order_relaxed);
+	Encode(sessionPrefix + _sequence / SEQUENCE_BLOCK, _buffer, PREFIX_LENGTH);
+	Encode(_sequence % SEQUENCE_BLOCK, _buffer + PREFIX_LENGTH, SEQUENCE_LENGTH);
+	_buffer[ID_LENGTH] = '\0';
+}
+
+string IdGenerator::NextId()
+{
+	char _buffer[ID_LENGTH + 1];
+	NextId(_buffer);
+	return string(_buffer, ID_LENGTH);
+}
+
+#endif
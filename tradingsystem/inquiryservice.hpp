@@ -44,7 +44,7 @@ public:
 	double GetPrice() const;
 
 	// Set the price that we have responded back with
-	double SetPrice(double _price);
+	void SetPrice(double _price);
 
 	// Get the current state on the inquiry
 	InquiryState GetState() const;
@@ -107,7 +107,7 @@ double Inquiry<T>::GetPrice() const
 }
 
 template<typename T>
-double Inquiry<T>::SetPrice(double _price)
+void Inquiry<T>::SetPrice(double _price)
 {
 	price = _price;
 }
@@ -257,6 +257,8 @@ void InquiryService<T>::OnMessage(Inquiry<T>& _data)
 			l->ProcessAdd(_data);
 		}
 
+		break;
+	default:
 		break;
 	}
 }
@@ -365,7 +367,7 @@ void InquiryConnector<T>::Subscribe(ifstream& _data)
 		string _productId = _cells[1];
 		Side _side;
 		if (_cells[2] == "BUY") _side = BUY;
-		else if (_cells[2] == "SELL") _side = SELL;
+		else _side = SELL;
 		long _quantity = stol(_cells[3]);
 		double _price = ConvertPrice(_cells[4]);
 		InquiryState _state;
@@ -373,7 +375,7 @@ void InquiryConnector<T>::Subscribe(ifstream& _data)
 		else if (_cells[5] == "QUOTED") _state = QUOTED;
 		else if (_cells[5] == "DONE") _state = DONE;
 		else if (_cells[5] == "REJECTED") _state = REJECTED;
-		else if (_cells[5] == "CUSTOMER_REJECTED") _state = CUSTOMER_REJECTED;
+		else _state = CUSTOMER_REJECTED;
 		T _product = GetBond(_productId);
 		Inquiry<T> _inquiry(_inquiryId, _product, _side, _quantity, _price, _state);
 		service->OnMessage(_inquiry);
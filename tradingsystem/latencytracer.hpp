@@ -0,0 +1,250 @@
+/**
+* latencytracer.hpp
+* Defines tick-to-trade latency tracing through the execution path.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef LATENCY_TRACER_HPP
+#define LATENCY_TRACER_HPP
+
+#include <iostream>
+#include <string>
+#include <array>
+#include <chrono>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+using namespace std;
+
+// Service boundaries a tick passes on its way to a booked trade
+enum LatencyStage { BOOK_RECEIVED, BOOK_PUBLISHED, ORDER_SIGNALLED, ORDER_SENT, TRADE_BOOKED };
+
+// Number of stages in the LatencyStage enum
+const int LATENCY_STAGE_COUNT = 5;
+
+/**
+* Tracing hooks placed at the service boundaries.
+* They compile to an empty expression unless LATENCY_TRACING is defined, so the
+* disabled build carries no cost at all on the execution path, and a hook still
+* forms a full statement wherever it is used.
+*/
+#ifdef LATENCY_TRACING
+#define TRACE_TICK_START() LatencyTracer::GetInstance().StartTick()
+#define TRACE_TICK_END() LatencyTracer::GetInstance().EndTick()
+#define TRACE_STAGE(_stage) LatencyTracer::GetInstance().RecordStage(_stage)
+#define TRACE_REPORT(_stream) LatencyTracer::GetInstance().Report(_stream)
+#else
+#define TRACE_TICK_START() ((void)0)
+#define TRACE_TICK_END() ((void)0)
+#define TRACE_STAGE(_stage) ((void)0)
+#define TRACE_REPORT(_stream) ((void)0)
+#endif
+
+// Read the time stamp counter, or a steady clock in nanoseconds where there is none.
+inline unsigned long long ReadTimestampCounter()
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+* Log-linear histogram of latencies in counter ticks.
+* Each power of two is split into 16 buckets, so a percentile read back is within
+* about 6% of the recorded value while recording stays a few instructions.
+*/
+class LatencyHistogram
+{
+
+public:
+
+	// ctor for an empty histogram
+	LatencyHistogram();
+
+	// Record a latency
+	void Record(unsigned long long _ticks);
+
+	// Get the number of latencies recorded
+	unsigned long long GetCount() const;
+
+	// Get the latency below which a fraction of the recorded latencies fall
+	unsigned long long GetPercentile(double _fraction) const;
+
+private:
+
+	static const int SUB_BUCKET_BITS = 4;
+	static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+	static const int BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+	array<unsigned long long, BUCKET_COUNT> counts;
+	unsigned long long count;
+
+	// Get the bucket of a latency
+	static int GetBucket(unsigned long long _ticks);
+
+	// Get the middle latency of a bucket
+	static unsigned long long GetBucketValue(int _bucket);
+
+};
+
+LatencyHistogram::LatencyHistogram()
+{
+	counts.fill(0);
+	count = 0;
+}
+
+int LatencyHistogram::GetBucket(unsigned long long _ticks)
+{
+	if (_ticks < SUB_BUCKET_COUNT) return (int)_ticks;
+	int _exponent = 63;
+	while (!(_ticks >> _exponent)) _exponent--;
+	int _shift = _exponent - SUB_BUCKET_BITS;
+	return (_shift + 1) * SUB_BUCKET_COUNT + (int)((_ticks >> _shift) & (SUB_BUCKET_COUNT - 1));
+}
+
+unsigned long long LatencyHistogram::GetBucketValue(int _bucket)
+{
+	if (_bucket < SUB_BUCKET_COUNT) return _bucket;
+	int _shift = _bucket / SUB_BUCKET_COUNT - 1;
+	unsigned long long _low = (unsigned long long)(SUB_BUCKET_COUNT + _bucket % SUB_BUCKET_COUNT) << _shift;
+	return _low + ((1ULL << _shift) >> 1);
+}
+
+void LatencyHistogram::Record(unsigned long long _ticks)
+{
+	counts[GetBucket(_ticks)]++;
+	count++;
+}
+
+unsigned long long LatencyHistogram::GetCount() const
+{
+	return count;
+}
+
+unsigned long long LatencyHistogram::GetPercentile(double _fraction) const
+{
+	if (count == 0) return 0;
+	unsigned long long _rank = (unsigned long long)(_fraction * count);
+	if (_rank >= count) _rank = count - 1;
+	unsigned long long _seen = 0;
+	for (int i = 0; i < BUCKET_COUNT; i++)
+	{
+		_seen += counts[i];
+		if (_seen > _rank) return GetBucketValue(i);
+	}
+	return GetBucketValue(BUCKET_COUNT - 1);
+}
+
+/**
+* Tracer of tick-to-trade latency through the services.
+* A tick starts when its first market data line enters the connector and ends
+* once its order book has been fully dispatched. Services dispatch synchronously,
+* so every event raised while the tick is in flight belongs to it, and each
+* boundary records the counter ticks elapsed since the tick started into the
+* histogram of its stage. Counter ticks are turned into nanoseconds against the
+* steady clock when the report is written.
+*/
+class LatencyTracer
+{
+
+public:
+
+	// Get the tracer of the process
+	static LatencyTracer& GetInstance();
+
+	// Start a tick
+	void StartTick();
+
+	// End the current tick
+	void EndTick();
+
+	// Record the current tick reaching a stage
+	void RecordStage(LatencyStage _stage);
+
+	// Get the histogram of a stage
+	const LatencyHistogram& GetHistogram(LatencyStage _stage) const;
+
+	// Get the number of nanoseconds in a counter tick
+	double GetNanosecondsPerTick() const;
+
+	// Write the percentiles of each stage
+	void Report(ostream& _stream) const;
+
+private:
+
+	// ctor for a latency tracer
+	LatencyTracer();
+
+	array<LatencyHistogram, LATENCY_STAGE_COUNT> histograms;
+	unsigned long long tickStart;
+	unsigned long long calibrationTicks;
+	chrono::steady_clock::time_point calibrationTime;
+
+};
+
+LatencyTracer::LatencyTracer()
+{
+	tickStart = 0;
+	calibrationTicks = ReadTimestampCounter();
+	calibrationTime = chrono::steady_clock::now();
+}
+
+LatencyTracer& LatencyTracer::GetInstance()
+{
+	static LatencyTracer _tracer;
+	return _tracer;
+}
+
+void LatencyTracer::StartTick()
+{
+	tickStart = ReadTimestampCounter();
+}
+
+void LatencyTracer::EndTick()
+{
+	tickStart = 0;
+}
+
+void LatencyTracer::RecordStage(LatencyStage _stage)
+{
+	if (tickStart == 0) return;
+	histograms[_stage].Record(ReadTimestampCounter() - tickStart);
+}
+
+const LatencyHistogram& LatencyTracer::GetHistogram(LatencyStage _stage) const
+{
+	return histograms[_stage];
+}
+
+double LatencyTracer::GetNanosecondsPerTick() const
+{
+	double _nanoseconds = chrono::duration<double, nano>(chrono::steady_clock::now() - calibrationTime).count();
+	unsigned long long _ticks = ReadTimestampCounter() - calibrationTicks;
+	return _ticks > 0 ? _nanoseconds / _ticks : 1.0;
+}
+
+void LatencyTracer::Report(ostream& _stream) const
+{
+	static const char* _stages[] = { "BOOK_RECEIVED", "BOOK_PUBLISHED", "ORDER_SIGNALLED", "ORDER_SENT", "TRADE_BOOKED" };
+	static const double _fractions[] = { 0.5, 0.9, 0.99, 0.999, 0.9999 };
+	double _nanosecondsPerTick = GetNanosecondsPerTick();
+
+	_stream << "Tick-to-trade latency (ns): stage,count,p50,p90,p99,p99.9,p99.99" << endl;
+	for (int i = 0; i < LATENCY_STAGE_COUNT; i++)
+	{
+		_stream << _stages[i] << "," << histograms[i].GetCount();
+		for (auto& f : _fractions)
+		{
+			_stream << "," << (unsigned long long)(histograms[i].GetPercentile(f) * _nanosecondsPerTick + 0.5);
+		}
+		_stream << endl;
+	}
+}
+
+#endif
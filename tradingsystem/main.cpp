@@ -6,15 +6,21 @@
 #include "products.hpp"
 #include "algoexecutionservice.hpp"
 #include "algostreamingservice.hpp"
+#include "bookanalyticsservice.hpp"
+#include "checkpoint.hpp"
 #include "executionservice.hpp"
 #include "guiservice.hpp"
 #include "historicaldataservice.hpp"
 #include "inquiryservice.hpp"
 #include "marketdataservice.hpp"
+#include "pnlservice.hpp"
+#include "positionlimitservice.hpp"
 #include "positionservice.hpp"
+#include "pretraderiskservice.hpp"
 #include "pricingservice.hpp"
 #include "riskservice.hpp"
 #include "streamingservice.hpp"
+#include "tickstoreservice.hpp"
 #include "tradebookingservice.hpp"
 
 using namespace std;
@@ -29,8 +35,13 @@ int main()
 	TradeBookingService<Bond> tradeBookingService;
 	PositionService<Bond> positionService;
 	RiskService<Bond> riskService;
+	PnLService<Bond> pnlService;
+	PositionLimitService<Bond> positionLimitService;
 	MarketDataService<Bond> marketDataService;
+	BookAnalyticsService<Bond> bookAnalyticsService;
+	TickStoreService<Bond> tickStoreService;
 	AlgoExecutionService<Bond> algoExecutionService;
+	PreTradeRiskService<Bond> preTradeRiskService;
 	AlgoStreamingService<Bond> algoStreamingService;
 	GUIService<Bond> guiService;
 	ExecutionService<Bond> executionService;
@@ -41,19 +52,31 @@ int main()
 	HistoricalDataService<ExecutionOrder<Bond>> historicalExecutionService(EXECUTION);
 	HistoricalDataService<PriceStream<Bond>> historicalStreamingService(STREAMING);
 	HistoricalDataService<Inquiry<Bond>> historicalInquiryService(INQUIRY);
+	TradeDeduplicator tradeDeduplicator(65536, 86400000000LL, false);
+	Checkpointer<Bond> checkpointer(&positionService, &riskService, tradeBookingService.GetConnector(), "checkpoint.bin", 0);
 	cout << TimeStamp() << "Services Initialized." << endl;
 
 	cout << TimeStamp() << "Services Linking..." << endl;
 	pricingService.AddListener(algoStreamingService.GetListener());
 	pricingService.AddListener(guiService.GetListener());
+	pricingService.AddListener(pnlService.GetPricingListener());
 	algoStreamingService.AddListener(streamingService.GetListener());
 	streamingService.AddListener(historicalStreamingService.GetListener());
+	marketDataService.AddListener(tickStoreService.GetListener());
+	marketDataService.AddListener(bookAnalyticsService.GetListener());
 	marketDataService.AddListener(algoExecutionService.GetListener());
-	algoExecutionService.AddListener(executionService.GetListener());
+	algoExecutionService.AddListener(preTradeRiskService.GetListener());
+	preTradeRiskService.SetMarketDataService(&marketDataService);
+	preTradeRiskService.AddOrderListener(executionService.GetListener());
 	executionService.AddListener(tradeBookingService.GetListener());
 	executionService.AddListener(historicalExecutionService.GetListener());
+	tradeBookingService.SetTradeDeduplicator(&tradeDeduplicator);
 	tradeBookingService.AddListener(positionService.GetListener());
+	tradeBookingService.AddListener(pnlService.GetTradeListener());
 	positionService.AddListener(riskService.GetListener());
+	riskService.SetPositionService(&positionService);
+	positionService.AddListener(preTradeRiskService.GetPositionListener());
+	positionService.AddListener(positionLimitService.GetListener());
 	positionService.AddListener(historicalPositionService.GetListener());
 	riskService.AddListener(historicalRiskService.GetListener());
 	inquiryService.AddListener(historicalInquiryService.GetListener());
@@ -64,9 +87,12 @@ int main()
 	pricingService.GetConnector()->Subscribe(priceData);
 	cout << TimeStamp() << "Price Data Processed." << endl;
 
+	if (checkpointer.Load()) cout << TimeStamp() << "Checkpoint Loaded." << endl;
+
 	cout << TimeStamp() << "Trade Data Processing..." << endl;
 	ifstream tradeData("trades.txt");
 	tradeBookingService.GetConnector()->Subscribe(tradeData);
+	checkpointer.Checkpoint();
 	cout << TimeStamp() << "Trade Data Processed." << endl;
 
 	cout << TimeStamp() << "Market Data Processing..." << endl;
@@ -79,6 +105,9 @@ int main()
 	inquiryService.GetConnector()->Subscribe(inquiryData);
 	cout << TimeStamp() << "Inquiry Data Processed." << endl;
 
+	TRACE_REPORT(cout);
+	checkpointer.Flush();
+
 	cout << TimeStamp() << "Program Ending..." << endl;
 	cout << TimeStamp() << "Program Ended." << endl;
 	system("pause");
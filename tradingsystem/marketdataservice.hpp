@@ -10,7 +10,12 @@
 
 #include <string>
 #include <vector>
+#include <array>
+#include <utility>
+#include <initializer_list>
 #include "soa.hpp"
+#include "topofbooktable.hpp"
+#include "latencytracer.hpp"
 
 using namespace std;
 
@@ -105,11 +110,56 @@ const Order& BidOffer::GetOfferOrder() const
 	return offerOrder;
 }
 
+/**
+* Compile-time helpers over the fixed depth stacks of an order book.
+* The level loops are expanded through index sequences, so a book of depth N
+* compiles to straight-line code with no loop counter.
+*/
+template<size_t N, size_t... I>
+size_t BestBidLevel(const array<Order, N>& _stack, index_sequence<I...>)
+{
+	size_t _best = 0;
+	(void)initializer_list<int>{ (_best = (_stack[I].GetQuantity() > 0 && (_stack[_best].GetQuantity() == 0 || _stack[I].GetPrice() > _stack[_best].GetPrice())) ? I : _best, 0)... };
+	return _best;
+}
+
+template<size_t N, size_t... I>
+size_t BestOfferLevel(const array<Order, N>& _stack, index_sequence<I...>)
+{
+	size_t _best = 0;
+	(void)initializer_list<int>{ (_best = (_stack[I].GetQuantity() > 0 && (_stack[_best].GetQuantity() == 0 || _stack[I].GetPrice() < _stack[_best].GetPrice())) ? I : _best, 0)... };
+	return _best;
+}
+
+template<size_t N>
+void AggregateLevel(const Order& _order, array<Order, N>& _to, size_t& _count, PricingSide _side)
+{
+	if (_order.GetQuantity() == 0) return;
+	for (size_t i = 0; i < _count; i++)
+	{
+		if (_to[i].GetPrice() == _order.GetPrice())
+		{
+			_to[i] = Order(_order.GetPrice(), _to[i].GetQuantity() + _order.GetQuantity(), _side);
+			return;
+		}
+	}
+	_to[_count++] = Order(_order.GetPrice(), _order.GetQuantity(), _side);
+}
+
+template<size_t N, size_t... I>
+size_t AggregateLevels(const array<Order, N>& _from, array<Order, N>& _to, PricingSide _side, index_sequence<I...>)
+{
+	size_t _count = 0;
+	(void)initializer_list<int>{ (AggregateLevel(_from[I], _to, _count, _side), 0)... };
+	return _count;
+}
+
 /**
 * Order book with a bid and offer stack.
 * Type T is the product type.
+* N is the book depth, fixed at compile time so the stacks are stored inline.
 */
-template<typename T>
+template<typename T, size_t N = 5>
 class OrderBook
 {
 
@@ -117,102 +167,246 @@ public:
 
 	// ctor for the order book
 	OrderBook() = default;
-	OrderBook(const T& _product, const vector<Order>& _bidStack, const vector<Order>& _offerStack);
+	OrderBook(const T& _product, const array<Order, N>& _bidStack, const array<Order, N>& _offerStack);
 
 	// Get the product
 	const T& GetProduct() const;
 
 	// Get the bid stack
-	const vector<Order>& GetBidStack() const;
+	const array<Order, N>& GetBidStack() const;
 
 	// Get the offer stack
-	const vector<Order>& GetOfferStack() const;
+	const array<Order, N>& GetOfferStack() const;
 
 	// Get the best bid/offer order
-	const BidOffer& GetBidOffer() const;
+	BidOffer GetBidOffer() const;
+
+	// Get the order book with orders at the same price merged into one level
+	OrderBook<T, N> Aggregate() const;
+
+	// Get the order book depth
+	static constexpr size_t GetDepth() { return N; }
 
 private:
 	T product;
-	vector<Order> bidStack;
-	vector<Order> offerStack;
+	array<Order, N> bidStack;
+	array<Order, N> offerStack;
 
 };
 
-template<typename T>
-OrderBook<T>::OrderBook(const T& _product, const vector<Order>& _bidStack, const vector<Order>& _offerStack) :
+template<typename T, size_t N>
+OrderBook<T, N>::OrderBook(const T& _product, const array<Order, N>& _bidStack, const array<Order, N>& _offerStack) :
 	product(_product), bidStack(_bidStack), offerStack(_offerStack)
 {
 }
 
-template<typename T>
-const T& OrderBook<T>::GetProduct() const
+template<typename T, size_t N>
+const T& OrderBook<T, N>::GetProduct() const
 {
 	return product;
 }
 
-template<typename T>
-const vector<Order>& OrderBook<T>::GetBidStack() const
+template<typename T, size_t N>
+const array<Order, N>& OrderBook<T, N>::GetBidStack() const
 {
 	return bidStack;
 }
 
-template<typename T>
-const vector<Order>& OrderBook<T>::GetOfferStack() const
+template<typename T, size_t N>
+const array<Order, N>& OrderBook<T, N>::GetOfferStack() const
 {
 	return offerStack;
 }
 
-template<typename T>
-const BidOffer& OrderBook<T>::GetBidOffer() const
+template<typename T, size_t N>
+BidOffer OrderBook<T, N>::GetBidOffer() const
+{
+	size_t _bidLevel = BestBidLevel(bidStack, make_index_sequence<N>());
+	size_t _offerLevel = BestOfferLevel(offerStack, make_index_sequence<N>());
+	return BidOffer(bidStack[_bidLevel], offerStack[_offerLevel]);
+}
+
+template<typename T, size_t N>
+OrderBook<T, N> OrderBook<T, N>::Aggregate() const
+{
+	array<Order, N> _bidStack;
+	_bidStack.fill(Order(0.0, 0, BID));
+	AggregateLevels(bidStack, _bidStack, BID, make_index_sequence<N>());
+
+	array<Order, N> _offerStack;
+	_offerStack.fill(Order(0.0, 0, OFFER));
+	AggregateLevels(offerStack, _offerStack, OFFER, make_index_sequence<N>());
+
+	return OrderBook<T, N>(product, _bidStack, _offerStack);
+}
+
+/**
+* A changed level of an order book, with the new order at that level.
+*/
+class LevelChange
 {
-	double _bidPrice = INT_MIN;
-	Order _bidOrder;
-	for (auto& b : bidStack)
+
+public:
+
+	// ctor for a level change
+	LevelChange() = default;
+	LevelChange(size_t _level, const Order& _order);
+
+	// Get the level that changed
+	size_t GetLevel() const;
+
+	// Get the new order at the level
+	const Order& GetOrder() const;
+
+private:
+	size_t level;
+	Order order;
+
+};
+
+LevelChange::LevelChange(size_t _level, const Order& _order) :
+	order(_order)
+{
+	level = _level;
+}
+
+size_t LevelChange::GetLevel() const
+{
+	return level;
+}
+
+const Order& LevelChange::GetOrder() const
+{
+	return order;
+}
+
+/**
+* Order book delta holding only the levels changed by an update.
+* Changes are ordered by level, so a consumer of the top L levels reads a prefix.
+* Type T is the product type.
+* N is the book depth.
+*/
+template<typename T, size_t N = 5>
+class OrderBookDelta
+{
+
+public:
+
+	// ctor for an order book delta
+	OrderBookDelta() = default;
+
+	// Get the product
+	const T& GetProduct() const;
+
+	// Get the update sequence number of the product
+	long GetSequence() const;
+
+	// Get the number of changed levels
+	size_t GetChangeCount() const;
+
+	// Get the number of changed levels within the top levels
+	size_t GetChangeCount(size_t _levels) const;
+
+	// Get a changed level
+	const LevelChange& GetChange(size_t _index) const;
+
+	// Compute the changes between two books of a product, which must outlive the delta
+	void Compute(const T& _product, const OrderBook<T, N>& _from, const OrderBook<T, N>& _to, long _sequence);
+
+private:
+	const T* product;
+	long sequence;
+	size_t count;
+	array<LevelChange, N * 2> changes;
+	array<size_t, N + 1> levelOffsets;
+
+};
+
+template<typename T, size_t N>
+const T& OrderBookDelta<T, N>::GetProduct() const
+{
+	return *product;
+}
+
+template<typename T, size_t N>
+long OrderBookDelta<T, N>::GetSequence() const
+{
+	return sequence;
+}
+
+template<typename T, size_t N>
+size_t OrderBookDelta<T, N>::GetChangeCount() const
+{
+	return count;
+}
+
+template<typename T, size_t N>
+size_t OrderBookDelta<T, N>::GetChangeCount(size_t _levels) const
+{
+	if (_levels > N) _levels = N;
+	return levelOffsets[_levels];
+}
+
+template<typename T, size_t N>
+const LevelChange& OrderBookDelta<T, N>::GetChange(size_t _index) const
+{
+	return changes[_index];
+}
+
+template<typename T, size_t N>
+void OrderBookDelta<T, N>::Compute(const T& _product, const OrderBook<T, N>& _from, const OrderBook<T, N>& _to, long _sequence)
+{
+	const array<Order, N>& _fromBids = _from.GetBidStack();
+	const array<Order, N>& _fromOffers = _from.GetOfferStack();
+	const array<Order, N>& _toBids = _to.GetBidStack();
+	const array<Order, N>& _toOffers = _to.GetOfferStack();
+
+	product = &_product;
+	sequence = _sequence;
+	count = 0;
+	levelOffsets[0] = 0;
+	for (size_t i = 0; i < N; i++)
 	{
-		double _price = b.GetPrice();
-		if (_price > _bidPrice)
+		if (_toBids[i].GetPrice() != _fromBids[i].GetPrice() || _toBids[i].GetQuantity() != _fromBids[i].GetQuantity())
 		{
-			_bidPrice = _price;
-			_bidOrder = b;
+			changes[count++] = LevelChange(i, _toBids[i]);
 		}
-	}
-
-	double _offerPrice = INT_MAX;
-	Order _offerOrder;
-	for (auto& o : offerStack)
-	{
-		double _price = o.GetPrice();
-		if (_price < _offerPrice)
+		if (_toOffers[i].GetPrice() != _fromOffers[i].GetPrice() || _toOffers[i].GetQuantity() != _fromOffers[i].GetQuantity())
 		{
-			_offerPrice = _price;
-			_offerOrder = o;
+			changes[count++] = LevelChange(i, _toOffers[i]);
 		}
+		levelOffsets[i + 1] = count;
 	}
-
-	return BidOffer(_bidOrder, _offerOrder);
 }
 
 /**
 * Pre-declearations to avoid errors.
 */
-template<typename T>
+template<typename T, size_t N = 5>
 class MarketDataConnector;
 
 /**
 * Market Data Service which distributes market data
 * Keyed on product identifier.
 * Type T is the product type.
+* N is the book depth.
 */
-template<typename T>
-class MarketDataService : public Service<string, OrderBook<T>>
+template<typename T, size_t N = 5>
+class MarketDataService : public Service<string, OrderBook<T, N>>
 {
 
 private:
 
-	map<string, OrderBook<T>> orderBooks;
-	vector<ServiceListener<OrderBook<T>>*> listeners;
-	MarketDataConnector<T>* connector;
-	int bookDepth;
+	map<string, OrderBook<T, N>> orderBooks;
+	map<string, long> sequences;
+	vector<ServiceListener<OrderBook<T, N>>*> listeners;
+	vector<ServiceListener<OrderBook<T, N>>*> snapshotListeners;
+	vector<long> snapshotIntervals;
+	vector<ServiceListener<OrderBookDelta<T, N>>*> deltaListeners;
+	vector<size_t> deltaLevels;
+	OrderBookDelta<T, N> delta;
+	MarketDataConnector<T, N>* connector;
+	TopOfBookTable topOfBookTable;
 
 public:
 
@@ -221,177 +415,229 @@ public:
 	~MarketDataService();
 
 	// Get data on our service given a key
-	OrderBook<T>& GetData(string _key);
+	OrderBook<T, N>& GetData(string _key);
 
 	// The callback that a Connector should invoke for any new or updated data
-	void OnMessage(OrderBook<T>& _data);
+	void OnMessage(OrderBook<T, N>& _data);
 
 	// Add a listener to the Service for callbacks on add, remove, and update events for data to the Service
-	void AddListener(ServiceListener<OrderBook<T>>* _listener);
+	void AddListener(ServiceListener<OrderBook<T, N>>* _listener);
 
 	// Get all listeners on the Service
-	const vector<ServiceListener<OrderBook<T>>*>& GetListeners() const;
+	const vector<ServiceListener<OrderBook<T, N>>*>& GetListeners() const;
+
+	// Add a listener receiving the full order book every given number of updates of a product, rejecting an interval below 1
+	bool AddSnapshotListener(ServiceListener<OrderBook<T, N>>* _listener, long _interval);
+
+	// Add a listener receiving only the changed levels, for updates that touch the top given levels
+	void AddDeltaListener(ServiceListener<OrderBookDelta<T, N>>* _listener, size_t _levels = N);
 
 	// Get the connector of the service
-	MarketDataConnector<T>* GetConnector();
+	MarketDataConnector<T, N>* GetConnector();
 
 	// Get the order book depth of the service
 	int GetBookDepth() const;
 
+	// Get the top of book table across all products
+	const TopOfBookTable& GetTopOfBookTable() const;
+
 	// Get the best bid/offer order
-	const BidOffer& GetBestBidOffer(const string& _productId);
+	BidOffer GetBestBidOffer(const string& _productId);
 
 	// Aggregate the order book
-	const OrderBook<T>& AggregateDepth(const string& _productId);
+	OrderBook<T, N> AggregateDepth(const string& _productId);
 
 };
 
-template<typename T>
-MarketDataService<T>::MarketDataService()
+template<typename T, size_t N>
+MarketDataService<T, N>::MarketDataService()
 {
-	orderBooks = map<string, OrderBook<T>>();
-	listeners = vector<ServiceListener<OrderBook<T>>*>();
-	connector = new MarketDataConnector<T>(this);
-	bookDepth = 5;
+	orderBooks = map<string, OrderBook<T, N>>();
+	sequences = map<string, long>();
+	listeners = vector<ServiceListener<OrderBook<T, N>>*>();
+	snapshotListeners = vector<ServiceListener<OrderBook<T, N>>*>();
+	snapshotIntervals = vector<long>();
+	deltaListeners = vector<ServiceListener<OrderBookDelta<T, N>>*>();
+	deltaLevels = vector<size_t>();
+	connector = new MarketDataConnector<T, N>(this);
 }
 
-template<typename T>
-MarketDataService<T>::~MarketDataService() {}
+template<typename T, size_t N>
+MarketDataService<T, N>::~MarketDataService() {}
 
-template<typename T>
-OrderBook<T>& MarketDataService<T>::GetData(string _key)
+template<typename T, size_t N>
+OrderBook<T, N>& MarketDataService<T, N>::GetData(string _key)
 {
 	return orderBooks[_key];
 }
 
-template<typename T>
-void MarketDataService<T>::OnMessage(OrderBook<T>& _data)
+template<typename T, size_t N>
+void MarketDataService<T, N>::OnMessage(OrderBook<T, N>& _data)
 {
-	orderBooks[_data.GetProduct().GetProductId()] = _data;
+	const string& _productId = _data.GetProduct().GetProductId();
+	auto _iter = orderBooks.find(_productId);
+	bool _isNew = _iter == orderBooks.end();
+	if (_isNew) _iter = orderBooks.insert(make_pair(_productId, _data)).first;
+	long& _sequence = sequences[_productId];
+	_sequence++;
+
+	// Keep one canonical book per product; deltas are taken against it before it is overwritten,
+	// and point at its product, since the book passed in may not outlive them.
+	OrderBook<T, N>& _orderBook = _iter->second;
+	if (!deltaListeners.empty())
+	{
+		if (_isNew)
+		{
+			array<Order, N> _bidStack;
+			array<Order, N> _offerStack;
+			_bidStack.fill(Order(0.0, 0, BID));
+			_offerStack.fill(Order(0.0, 0, OFFER));
+			delta.Compute(_orderBook.GetProduct(), OrderBook<T, N>(_data.GetProduct(), _bidStack, _offerStack), _data, _sequence);
+		}
+		else
+		{
+			delta.Compute(_orderBook.GetProduct(), _orderBook, _data, _sequence);
+		}
+	}
+	if (!_isNew) _orderBook = _data;
 
+	BidOffer _bidOffer = _orderBook.GetBidOffer();
+	const Order& _bidOrder = _bidOffer.GetBidOrder();
+	const Order& _offerOrder = _bidOffer.GetOfferOrder();
+	topOfBookTable.Update(_productId, _bidOrder.GetPrice(), _bidOrder.GetQuantity(), _offerOrder.GetPrice(), _offerOrder.GetQuantity());
+
+	TRACE_STAGE(BOOK_PUBLISHED);
 	for (auto& l : listeners)
 	{
-		l->ProcessAdd(_data);
+		l->ProcessAdd(_orderBook);
+	}
+
+	for (size_t i = 0; i < snapshotListeners.size(); i++)
+	{
+		if ((_sequence - 1) % snapshotIntervals[i] == 0) snapshotListeners[i]->ProcessAdd(_orderBook);
+	}
+
+	if (!deltaListeners.empty())
+	{
+		for (size_t i = 0; i < deltaListeners.size(); i++)
+		{
+			if (delta.GetChangeCount(deltaLevels[i]) > 0) deltaListeners[i]->ProcessAdd(delta);
+		}
 	}
 }
 
-template<typename T>
-void MarketDataService<T>::AddListener(ServiceListener<OrderBook<T>>* _listener)
+template<typename T, size_t N>
+void MarketDataService<T, N>::AddListener(ServiceListener<OrderBook<T, N>>* _listener)
 {
 	listeners.push_back(_listener);
 }
 
-template<typename T>
-const vector<ServiceListener<OrderBook<T>>*>& MarketDataService<T>::GetListeners() const
+template<typename T, size_t N>
+const vector<ServiceListener<OrderBook<T, N>>*>& MarketDataService<T, N>::GetListeners() const
 {
 	return listeners;
 }
 
-template<typename T>
-MarketDataConnector<T>* MarketDataService<T>::GetConnector()
+template<typename T, size_t N>
+bool MarketDataService<T, N>::AddSnapshotListener(ServiceListener<OrderBook<T, N>>* _listener, long _interval)
 {
-	return connector;
+	if (_interval < 1) return false;
+	snapshotListeners.push_back(_listener);
+	snapshotIntervals.push_back(_interval);
+	return true;
 }
 
-template<typename T>
-int MarketDataService<T>::GetBookDepth() const
+template<typename T, size_t N>
+void MarketDataService<T, N>::AddDeltaListener(ServiceListener<OrderBookDelta<T, N>>* _listener, size_t _levels)
 {
-	return bookDepth;
+	deltaListeners.push_back(_listener);
+	deltaLevels.push_back(_levels);
 }
 
-template<typename T>
-const BidOffer& MarketDataService<T>::GetBestBidOffer(const string& _productId)
+template<typename T, size_t N>
+MarketDataConnector<T, N>* MarketDataService<T, N>::GetConnector()
 {
-	return orderBooks[_productId].GetBidOffer();
+	return connector;
 }
 
-template<typename T>
-const OrderBook<T>& MarketDataService<T>::AggregateDepth(const string& _productId)
+template<typename T, size_t N>
+int MarketDataService<T, N>::GetBookDepth() const
 {
-	T& _product = orderBooks[_productId].GetProduct();
+	return N;
+}
 
-	vector<Order>& _bidStackFrom = orderBooks[_productId].GetBidStack();
-	unordered_map<double, long> _bidHashTable;
-	for (auto& b : _bidStackFrom)
-	{
-		double _price = b.GetPrice();
-		long _quantity = b.GetQuantity();
-		_bidHashTable[_price] += _quantity;
-	}
-	vector<Order> _bidStackTo;
-	for (auto& p : _bidHashTable)
-	{
-		Order _bidOrder = Order(p.first, p.second, BID);
-		_bidStackTo.push_back(_bidOrder);
-	}
+template<typename T, size_t N>
+const TopOfBookTable& MarketDataService<T, N>::GetTopOfBookTable() const
+{
+	return topOfBookTable;
+}
 
-	vector<Order>& _offerStackFrom = orderBooks[_productId].GetOfferStack();
-	unordered_map<double, long> _offerHashTable;
-	for (auto& o : _offerStackFrom)
-	{
-		double _price = o.GetPrice();
-		long _quantity = o.GetQuantity();
-		_bidHashTable[_price] += _quantity;
-	}
-	vector<Order> _offerStackTo;
-	for (auto& p : _offerHashTable)
-	{
-		Order _offerOrder = Order(p.first, p.second, OFFER);
-		_offerStackTo.push_back(_offerOrder);
-	}
+template<typename T, size_t N>
+BidOffer MarketDataService<T, N>::GetBestBidOffer(const string& _productId)
+{
+	return orderBooks[_productId].GetBidOffer();
+}
 
-	return OrderBook<T>(_product, _bidStackTo, _offerStackTo);
+template<typename T, size_t N>
+OrderBook<T, N> MarketDataService<T, N>::AggregateDepth(const string& _productId)
+{
+	return orderBooks[_productId].Aggregate();
 }
 
 /**
 * Market Data Connector subscribing data to Market Data Service.
 * Type T is the product type.
+* N is the book depth.
 */
-template<typename T>
-class MarketDataConnector : public Connector<OrderBook<T>>
+template<typename T, size_t N>
+class MarketDataConnector : public Connector<OrderBook<T, N>>
 {
 
 private:
 
-	MarketDataService<T>* service;
+	MarketDataService<T, N>* service;
 
 public:
 
 	// Connector and Destructor
-	MarketDataConnector(MarketDataService<T>* _service);
+	MarketDataConnector(MarketDataService<T, N>* _service);
 	~MarketDataConnector();
 
 	// Publish data to the Connector
-	void Publish(OrderBook<T>& _data);
+	void Publish(OrderBook<T, N>& _data);
 
 	// Subscribe data from the Connector
 	void Subscribe(ifstream& _data);
 
 };
 
-template<typename T>
-MarketDataConnector<T>::MarketDataConnector(MarketDataService<T>* _service)
+template<typename T, size_t N>
+MarketDataConnector<T, N>::MarketDataConnector(MarketDataService<T, N>* _service)
 {
 	service = _service;
 }
 
-template<typename T>
-MarketDataConnector<T>::~MarketDataConnector() {}
+template<typename T, size_t N>
+MarketDataConnector<T, N>::~MarketDataConnector() {}
 
-template<typename T>
-void MarketDataConnector<T>::Publish(OrderBook<T>& _data) {}
+template<typename T, size_t N>
+void MarketDataConnector<T, N>::Publish(OrderBook<T, N>& _data) {}
 
-template<typename T>
-void MarketDataConnector<T>::Subscribe(ifstream& _data)
+template<typename T, size_t N>
+void MarketDataConnector<T, N>::Subscribe(ifstream& _data)
 {
-	int _bookDepth = service->GetBookDepth();
-	int _thread = _bookDepth * 2;
-	long _count = 0;
-	vector<Order> _bidStack;
-	vector<Order> _offerStack;
+	const size_t _thread = N * 2;
+	size_t _count = 0;
+	size_t _bidCount = 0;
+	size_t _offerCount = 0;
+	array<Order, N> _bidStack;
+	array<Order, N> _offerStack;
+	_bidStack.fill(Order(0.0, 0, BID));
+	_offerStack.fill(Order(0.0, 0, OFFER));
 	string _line;
 	while (getline(_data, _line))
 	{
+		if (_count % _thread == 0) TRACE_TICK_START();
 		string _productId;
 
 		stringstream _lineStream(_line);
@@ -407,15 +653,15 @@ void MarketDataConnector<T>::Subscribe(ifstream& _data)
 		long _quantity = stol(_cells[2]);
 		PricingSide _side;
 		if (_cells[3] == "BID") _side = BID;
-		else if (_cells[3] == "OFFER") _side = OFFER;
+		else _side = OFFER;
 		Order _order(_price, _quantity, _side);
 		switch (_side)
 			{
 			case BID:
-				_bidStack.push_back(_order); 
+				if (_bidCount < N) _bidStack[_bidCount++] = _order;
 				break;
 			case OFFER:
-				_offerStack.push_back(_order); 
+				if (_offerCount < N) _offerStack[_offerCount++] = _order;
 				break;
 			}
 		
@@ -423,11 +669,15 @@ void MarketDataConnector<T>::Subscribe(ifstream& _data)
 		if (_count % _thread == 0)
 		{
 			T _product = GetBond(_productId);
-			OrderBook<T> _orderBook(_product, _bidStack, _offerStack);
+			OrderBook<T, N> _orderBook(_product, _bidStack, _offerStack);
+			TRACE_STAGE(BOOK_RECEIVED);
 			service->OnMessage(_orderBook);
+			TRACE_TICK_END();
 
-			_bidStack = vector<Order>();
-			_offerStack = vector<Order>();
+			_bidCount = 0;
+			_offerCount = 0;
+			_bidStack.fill(Order(0.0, 0, BID));
+			_offerStack.fill(Order(0.0, 0, OFFER));
 		}
 	}
 }
@@ -0,0 +1,767 @@
+/**
+* matchingengine.hpp
+* Defines the data types and Service for a local price-time priority matching engine.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef MATCHING_ENGINE_HPP
+#define MATCHING_ENGINE_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <cmath>
+#include "soa.hpp"
+#include "marketdataservice.hpp"
+#include "algoexecutionservice.hpp"
+
+using namespace std;
+
+enum ExecutionEventType { EXECUTION_ACKED, EXECUTION_PARTIALLY_FILLED, EXECUTION_FILLED, EXECUTION_CANCELLED, EXECUTION_REJECTED };
+
+/**
+* An execution event for an order on a venue: an ack, a fill, a cancel or a reject.
+* Type T is the product type.
+*/
+template<typename T>
+class ExecutionEvent
+{
+
+public:
+
+	// ctor for an execution event
+	ExecutionEvent() = default;
+	ExecutionEvent(const T& _product, Market _market, string _orderId, ExecutionEventType _type, PricingSide _side, double _price, long _quantity, long _leavesQuantity);
+
+	// Get the product
+	const T& GetProduct() const;
+
+	// Get the market of the event
+	Market GetMarket() const;
+
+	// Get the order ID
+	const string& GetOrderId() const;
+
+	// Get the event type
+	ExecutionEventType GetType() const;
+
+	// Get the pricing side of the order
+	PricingSide GetPricingSide() const;
+
+	// Get the fill price, or the order price for other events
+	double GetPrice() const;
+
+	// Get the fill quantity, or zero for other events
+	long GetQuantity() const;
+
+	// Get the quantity still open on the order
+	long GetLeavesQuantity() const;
+
+	// Change attributes to strings
+	vector<string> ToStrings() const;
+
+private:
+	T product;
+	Market market;
+	string orderId;
+	ExecutionEventType type;
+	PricingSide side;
+	double price;
+	long quantity;
+	long leavesQuantity;
+
+};
+
+template<typename T>
+ExecutionEvent<T>::ExecutionEvent(const T& _product, Market _market, string _orderId, ExecutionEventType _type, PricingSide _side, double _price, long _quantity, long _leavesQuantity) :
+	product(_product)
+{
+	market = _market;
+	orderId = _orderId;
+	type = _type;
+	side = _side;
+	price = _price;
+	quantity = _quantity;
+	leavesQuantity = _leavesQuantity;
+}
+
+template<typename T>
+const T& ExecutionEvent<T>::GetProduct() const
+{
+	return product;
+}
+
+template<typename T>
+Market ExecutionEvent<T>::GetMarket() const
+{
+	return market;
+}
+
+template<typename T>
+const string& ExecutionEvent<T>::GetOrderId() const
+{
+	return orderId;
+}
+
+template<typename T>
+ExecutionEventType ExecutionEvent<T>::GetType() const
+{
+	return type;
+}
+
+template<typename T>
+PricingSide ExecutionEvent<T>::GetPricingSide() const
+{
+	return side;
+}
+
+template<typename T>
+double ExecutionEvent<T>::GetPrice() const
+{
+	return price;
+}
+
+template<typename T>
+long ExecutionEvent<T>::GetQuantity() const
+{
+	return quantity;
+}
+
+template<typename T>
+long ExecutionEvent<T>::GetLeavesQuantity() const
+{
+	return leavesQuantity;
+}
+
+template<typename T>
+vector<string> ExecutionEvent<T>::ToStrings() const
+{
+	string _product = product.GetProductId();
+	string _market;
+	switch (market)
+	{
+	case BROKERTEC:
+		_market = "BROKERTEC";
+		break;
+	case ESPEED:
+		_market = "ESPEED";
+		break;
+	case CME:
+		_market = "CME";
+		break;
+	}
+	string _type;
+	switch (type)
+	{
+	case EXECUTION_ACKED:
+		_type = "ACKED";
+		break;
+	case EXECUTION_PARTIALLY_FILLED:
+		_type = "PARTIALLY_FILLED";
+		break;
+	case EXECUTION_FILLED:
+		_type = "FILLED";
+		break;
+	case EXECUTION_CANCELLED:
+		_type = "CANCELLED";
+		break;
+	case EXECUTION_REJECTED:
+		_type = "REJECTED";
+		break;
+	}
+	string _side;
+	switch (side)
+	{
+	case BID:
+		_side = "BID";
+		break;
+	case OFFER:
+		_side = "OFFER";
+		break;
+	}
+
+	vector<string> _strings;
+	_strings.push_back(_product);
+	_strings.push_back(_market);
+	_strings.push_back(orderId);
+	_strings.push_back(_type);
+	_strings.push_back(_side);
+	_strings.push_back(ConvertPrice(price));
+	_strings.push_back(to_string(quantity));
+	_strings.push_back(to_string(leavesQuantity));
+	return _strings;
+}
+
+/**
+* Price-time priority limit order book of one product on one venue.
+* Prices are held as integer ticks of 1/256 and each price level is a FIFO
+* list threaded through a pool of order slots. Levels of a side are kept in a
+* vector sorted so the best level is at the back, and erased levels leave their
+* capacity behind, so resting, matching and removing an order do not allocate
+* once the pools have warmed up.
+*
+* Sides follow the ExecutionOrder convention used by the trade booking:
+* an order on the BID side sells into the bids, an order on the OFFER side
+* buys from the offers. A resting sell rests on the offer side and vice versa.
+*/
+class MatchingBook
+{
+
+public:
+
+	// ctor for a matching book
+	MatchingBook();
+
+	// Match an incoming order, calling back for each fill, and return the quantity left
+	template<typename F>
+	long Match(bool _isBuy, bool _hasLimit, long _limitTick, long _quantity, F& _onFill);
+
+	// Get the quantity available to an incoming order up to a limit
+	long GetAvailable(bool _isBuy, bool _hasLimit, long _limitTick, long _quantity) const;
+
+	// Rest an order at the back of its price level and return its slot
+	int Rest(bool _isBuy, long _tick, long _quantity, const string& _orderId, bool _isExternal);
+
+	// Remove a resting order by slot
+	void Remove(int _slot);
+
+	// Remove every external resting order
+	void ClearExternal();
+
+	// Get the order ID of a slot
+	const string& GetOrderId(int _slot) const;
+
+	// Is the order in a slot external liquidity?
+	bool IsExternal(int _slot) const;
+
+	// Get the quantity left on a slot
+	long GetQuantity(int _slot) const;
+
+private:
+
+	struct Slot
+	{
+		string orderId;
+		long tick;
+		long quantity;
+		int prev;
+		int next;
+		bool isBuy;
+		bool isExternal;
+	};
+
+	struct Level
+	{
+		long tick;
+		long quantity;
+		int head;
+		int tail;
+	};
+
+	vector<Slot> slots;
+	vector<int> freeSlots;
+	vector<int> externalSlots;
+	vector<Level> buyLevels;
+	vector<Level> sellLevels;
+
+	// Find the level of a tick on a side, or the position where it would go
+	static size_t FindLevel(const vector<Level>& _levels, bool _isBuy, long _tick);
+
+};
+
+MatchingBook::MatchingBook()
+{
+	slots = vector<Slot>();
+	freeSlots = vector<int>();
+	externalSlots = vector<int>();
+	buyLevels = vector<Level>();
+	sellLevels = vector<Level>();
+}
+
+size_t MatchingBook::FindLevel(const vector<Level>& _levels, bool _isBuy, long _tick)
+{
+	// Buys ascend and sells descend by tick, so the best level of either side is last.
+	size_t _low = 0;
+	size_t _high = _levels.size();
+	while (_low < _high)
+	{
+		size_t _middle = (_low + _high) / 2;
+		if (_isBuy ? _levels[_middle].tick < _tick : _levels[_middle].tick > _tick) _low = _middle + 1;
+		else _high = _middle;
+	}
+	return _low;
+}
+
+template<typename F>
+long MatchingBook::Match(bool _isBuy, bool _hasLimit, long _limitTick, long _quantity, F& _onFill)
+{
+	// A buy takes the lowest sells first, a sell takes the highest buys first.
+	// The best level is looked up again for every fill, since a fill callback may
+	// rest an order and move the levels.
+	vector<Level>& _levels = _isBuy ? sellLevels : buyLevels;
+	while (_quantity > 0 && !_levels.empty())
+	{
+		Level& _level = _levels.back();
+		long _tick = _level.tick;
+		if (_hasLimit && (_isBuy ? _tick > _limitTick : _tick < _limitTick)) break;
+
+		int _slot = _level.head;
+		long _fill = min(_quantity, slots[_slot].quantity);
+		_quantity -= _fill;
+		slots[_slot].quantity -= _fill;
+		_level.quantity -= _fill;
+		_onFill(_slot, _tick, _fill);
+		if (slots[_slot].quantity == 0) Remove(_slot);
+	}
+	return _quantity;
+}
+
+long MatchingBook::GetAvailable(bool _isBuy, bool _hasLimit, long _limitTick, long _quantity) const
+{
+	const vector<Level>& _levels = _isBuy ? sellLevels : buyLevels;
+	long _available = 0;
+	for (auto _iter = _levels.rbegin(); _iter != _levels.rend() && _available < _quantity; ++_iter)
+	{
+		if (_hasLimit && (_isBuy ? _iter->tick > _limitTick : _iter->tick < _limitTick)) break;
+		_available += _iter->quantity;
+	}
+	return _available;
+}
+
+int MatchingBook::Rest(bool _isBuy, long _tick, long _quantity, const string& _orderId, bool _isExternal)
+{
+	int _slot;
+	if (freeSlots.empty())
+	{
+		_slot = slots.size();
+		slots.push_back(Slot());
+	}
+	else
+	{
+		_slot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+
+	vector<Level>& _levels = _isBuy ? buyLevels : sellLevels;
+	size_t _index = FindLevel(_levels, _isBuy, _tick);
+	if (_index == _levels.size() || _levels[_index].tick != _tick)
+	{
+		Level _newLevel = { _tick, 0, -1, -1 };
+		_levels.insert(_levels.begin() + _index, _newLevel);
+	}
+	Level& _level = _levels[_index];
+
+	Slot& _s = slots[_slot];
+	_s.orderId = _orderId;
+	_s.tick = _tick;
+	_s.quantity = _quantity;
+	_s.prev = _level.tail;
+	_s.next = -1;
+	_s.isBuy = _isBuy;
+	_s.isExternal = _isExternal;
+	if (_level.tail >= 0) slots[_level.tail].next = _slot;
+	else _level.head = _slot;
+	_level.tail = _slot;
+	_level.quantity += _quantity;
+
+	if (_isExternal) externalSlots.push_back(_slot);
+	return _slot;
+}
+
+void MatchingBook::Remove(int _slot)
+{
+	Slot& _s = slots[_slot];
+	if (_s.tick < 0) return;
+	vector<Level>& _levels = _s.isBuy ? buyLevels : sellLevels;
+	size_t _index = FindLevel(_levels, _s.isBuy, _s.tick);
+	Level& _level = _levels[_index];
+	_level.quantity -= _s.quantity;
+	if (_s.prev >= 0) slots[_s.prev].next = _s.next;
+	else _level.head = _s.next;
+	if (_s.next >= 0) slots[_s.next].prev = _s.prev;
+	else _level.tail = _s.prev;
+	if (_level.head < 0) _levels.erase(_levels.begin() + _index);
+
+	_s.tick = -1;
+	_s.quantity = 0;
+	freeSlots.push_back(_slot);
+}
+
+void MatchingBook::ClearExternal()
+{
+	for (auto& s : externalSlots)
+	{
+		if (slots[s].isExternal) Remove(s);
+	}
+	externalSlots.clear();
+}
+
+const string& MatchingBook::GetOrderId(int _slot) const
+{
+	return slots[_slot].orderId;
+}
+
+bool MatchingBook::IsExternal(int _slot) const
+{
+	return slots[_slot].isExternal;
+}
+
+long MatchingBook::GetQuantity(int _slot) const
+{
+	return slots[_slot].quantity;
+}
+
+/**
+* Pre-declearations to avoid errors.
+*/
+template<typename T, size_t N = 5>
+class MatchingEngineToMarketDataListener;
+
+/**
+* Matching Engine simulating one venue with a price-time priority book per product.
+* Supports FOK, IOC, MARKET, LIMIT and STOP orders with partial fills, and
+* publishes acks, fills, cancels and rejects as execution events.
+* Books of any depth load as external liquidity. The listener of the engine takes
+* books of the default depth, and a listener of another depth can be made on it.
+* Keyed on order identifier.
+* Type T is the product type.
+*/
+template<typename T>
+class MatchingEngine : public Service<string, ExecutionEvent<T>>
+{
+
+private:
+
+	map<string, ExecutionEvent<T>> executionEvents;
+	vector<ServiceListener<ExecutionEvent<T>>*> listeners;
+	MatchingEngineToMarketDataListener<T>* listener;
+	Market market;
+	unordered_map<string, MatchingBook> books;
+	unordered_map<string, pair<ExecutionOrder<T>, int>> restingOrders;
+	unordered_map<string, ExecutionOrder<T>> stopOrders;
+	unordered_map<string, double> lastPrices;
+
+	// Convert a price to integer ticks of 1/256
+	static long ToTick(double _price);
+
+	// Publish an execution event to the listeners
+	void Publish(const T& _product, const string& _orderId, ExecutionEventType _type, PricingSide _side, double _price, long _quantity, long _leavesQuantity);
+
+	// Match an order against the book of its product
+	void Match(const ExecutionOrder<T>& _order, bool _isMarket);
+
+	// Trigger stop orders crossed by the last traded price of a product
+	void TriggerStops(const string& _productId);
+
+public:
+
+	// Constructor and destructor
+	MatchingEngine(Market _market);
+	~MatchingEngine();
+
+	// Get data on our service given a key
+	ExecutionEvent<T>& GetData(string _key);
+
+	// The callback that a Connector should invoke for any new or updated data
+	void OnMessage(ExecutionEvent<T>& _data);
+
+	// Add a listener to the Service for callbacks on add, remove, and update events for data to the Service
+	void AddListener(ServiceListener<ExecutionEvent<T>>* _listener);
+
+	// Get all listeners on the Service
+	const vector<ServiceListener<ExecutionEvent<T>>*>& GetListeners() const;
+
+	// Get the listener of the service
+	MatchingEngineToMarketDataListener<T>* GetListener();
+
+	// Get the market this engine simulates
+	Market GetMarket() const;
+
+	// Submit an order to the engine
+	void SubmitOrder(const ExecutionOrder<T>& _order);
+
+	// Cancel a resting or stop order
+	bool CancelOrder(const string& _orderId);
+
+	// Replace the external liquidity of a product with the levels of an order book
+	template<size_t N>
+	void LoadBook(const OrderBook<T, N>& _orderBook);
+
+};
+
+template<typename T>
+MatchingEngine<T>::MatchingEngine(Market _market)
+{
+	executionEvents = map<string, ExecutionEvent<T>>();
+	listeners = vector<ServiceListener<ExecutionEvent<T>>*>();
+	listener = new MatchingEngineToMarketDataListener<T>(this);
+	market = _market;
+}
+
+template<typename T>
+MatchingEngine<T>::~MatchingEngine() {}
+
+template<typename T>
+ExecutionEvent<T>& MatchingEngine<T>::GetData(string _key)
+{
+	return executionEvents[_key];
+}
+
+template<typename T>
+void MatchingEngine<T>::OnMessage(ExecutionEvent<T>& _data)
+{
+	executionEvents[_data.GetOrderId()] = _data;
+}
+
+template<typename T>
+void MatchingEngine<T>::AddListener(ServiceListener<ExecutionEvent<T>>* _listener)
+{
+	listeners.push_back(_listener);
+}
+
+template<typename T>
+const vector<ServiceListener<ExecutionEvent<T>>*>& MatchingEngine<T>::GetListeners() const
+{
+	return listeners;
+}
+
+template<typename T>
+MatchingEngineToMarketDataListener<T>* MatchingEngine<T>::GetListener()
+{
+	return listener;
+}
+
+template<typename T>
+Market MatchingEngine<T>::GetMarket() const
+{
+	return market;
+}
+
+template<typename T>
+long MatchingEngine<T>::ToTick(double _price)
+{
+	return (long)llround(_price * 256.0);
+}
+
+template<typename T>
+void MatchingEngine<T>::Publish(const T& _product, const string& _orderId, ExecutionEventType _type, PricingSide _side, double _price, long _quantity, long _leavesQuantity)
+{
+	if (listeners.empty()) return;
+	ExecutionEvent<T> _event(_product, market, _orderId, _type, _side, _price, _quantity, _leavesQuantity);
+	for (auto& l : listeners)
+	{
+		l->ProcessAdd(_event);
+	}
+}
+
+template<typename T>
+void MatchingEngine<T>::SubmitOrder(const ExecutionOrder<T>& _order)
+{
+	const T& _product = _order.GetProduct();
+	const string& _productId = _product.GetProductId();
+	const string& _orderId = _order.GetOrderId();
+	PricingSide _side = _order.GetPricingSide();
+	long _quantity = _order.GetVisibleQuantity() + _order.GetHiddenQuantity();
+	if (_quantity <= 0 || restingOrders.count(_orderId) || stopOrders.count(_orderId))
+	{
+		Publish(_product, _orderId, EXECUTION_REJECTED, _side, _order.GetPrice(), 0, 0);
+		return;
+	}
+
+	Publish(_product, _orderId, EXECUTION_ACKED, _side, _order.GetPrice(), 0, _quantity);
+	switch (_order.GetOrderType())
+	{
+	case STOP:
+		stopOrders[_orderId] = _order;
+		TriggerStops(_productId);
+		break;
+	case MARKET:
+		Match(_order, true);
+		break;
+	default:
+		Match(_order, false);
+		break;
+	}
+}
+
+template<typename T>
+void MatchingEngine<T>::Match(const ExecutionOrder<T>& _order, bool _isMarket)
+{
+	const T& _product = _order.GetProduct();
+	const string& _productId = _product.GetProductId();
+	const string& _orderId = _order.GetOrderId();
+	PricingSide _side = _order.GetPricingSide();
+	OrderType _orderType = _order.GetOrderType();
+	bool _isBuy = _side == OFFER;
+	long _limitTick = ToTick(_order.GetPrice());
+	long _quantity = _order.GetVisibleQuantity() + _order.GetHiddenQuantity();
+	MatchingBook& _book = books[_productId];
+
+	if (_orderType == FOK && _book.GetAvailable(_isBuy, !_isMarket, _limitTick, _quantity) < _quantity)
+	{
+		Publish(_product, _orderId, EXECUTION_CANCELLED, _side, _order.GetPrice(), 0, 0);
+		return;
+	}
+
+	long _leaves = _quantity;
+	double _lastPrice = 0.0;
+	bool _traded = false;
+	auto _onFill = [&](int _slot, long _tick, long _fill)
+	{
+		double _price = _tick / 256.0;
+		_leaves -= _fill;
+		_lastPrice = _price;
+		_traded = true;
+		Publish(_product, _orderId, _leaves > 0 ? EXECUTION_PARTIALLY_FILLED : EXECUTION_FILLED, _side, _price, _fill, _leaves);
+		if (!_book.IsExternal(_slot))
+		{
+			const string& _restingId = _book.GetOrderId(_slot);
+			long _restingLeaves = _book.GetQuantity(_slot);
+			Publish(_product, _restingId, _restingLeaves > 0 ? EXECUTION_PARTIALLY_FILLED : EXECUTION_FILLED, _isBuy ? BID : OFFER, _price, _fill, _restingLeaves);
+			if (_restingLeaves == 0) restingOrders.erase(_restingId);
+		}
+	};
+	_leaves = _book.Match(_isBuy, !_isMarket, _limitTick, _quantity, _onFill);
+
+	if (_leaves > 0)
+	{
+		if (_orderType == LIMIT)
+		{
+			int _slot = _book.Rest(_isBuy, _limitTick, _leaves, _orderId, false);
+			restingOrders[_orderId] = make_pair(_order, _slot);
+		}
+		else
+		{
+			Publish(_product, _orderId, EXECUTION_CANCELLED, _side, _order.GetPrice(), 0, 0);
+		}
+	}
+
+	if (_traded)
+	{
+		lastPrices[_productId] = _lastPrice;
+		TriggerStops(_productId);
+	}
+}
+
+template<typename T>
+void MatchingEngine<T>::TriggerStops(const string& _productId)
+{
+	auto _lastIter = lastPrices.find(_productId);
+	if (_lastIter == lastPrices.end() || stopOrders.empty()) return;
+	double _lastPrice = _lastIter->second;
+
+	// A buy stop triggers when the market trades at or above it, a sell stop at or below it.
+	vector<ExecutionOrder<T>> _triggered;
+	for (auto _iter = stopOrders.begin(); _iter != stopOrders.end();)
+	{
+		const ExecutionOrder<T>& _stop = _iter->second;
+		bool _isBuy = _stop.GetPricingSide() == OFFER;
+		if (_stop.GetProduct().GetProductId() == _productId && (_isBuy ? _lastPrice >= _stop.GetPrice() : _lastPrice <= _stop.GetPrice()))
+		{
+			_triggered.push_back(_stop);
+			_iter = stopOrders.erase(_iter);
+		}
+		else
+		{
+			++_iter;
+		}
+	}
+	for (auto& s : _triggered)
+	{
+		Match(s, true);
+	}
+}
+
+template<typename T>
+bool MatchingEngine<T>::CancelOrder(const string& _orderId)
+{
+	auto _stopIter = stopOrders.find(_orderId);
+	if (_stopIter != stopOrders.end())
+	{
+		const ExecutionOrder<T>& _stop = _stopIter->second;
+		Publish(_stop.GetProduct(), _orderId, EXECUTION_CANCELLED, _stop.GetPricingSide(), _stop.GetPrice(), 0, 0);
+		stopOrders.erase(_stopIter);
+		return true;
+	}
+
+	auto _restingIter = restingOrders.find(_orderId);
+	if (_restingIter == restingOrders.end()) return false;
+	const ExecutionOrder<T>& _resting = _restingIter->second.first;
+	int _slot = _restingIter->second.second;
+	books[_resting.GetProduct().GetProductId()].Remove(_slot);
+	Publish(_resting.GetProduct(), _orderId, EXECUTION_CANCELLED, _resting.GetPricingSide(), _resting.GetPrice(), 0, 0);
+	restingOrders.erase(_restingIter);
+	return true;
+}
+
+template<typename T>
+template<size_t N>
+void MatchingEngine<T>::LoadBook(const OrderBook<T, N>& _orderBook)
+{
+	const string& _productId = _orderBook.GetProduct().GetProductId();
+	MatchingBook& _book = books[_productId];
+	_book.ClearExternal();
+	for (auto& b : _orderBook.GetBidStack())
+	{
+		if (b.GetQuantity() > 0) _book.Rest(true, ToTick(b.GetPrice()), b.GetQuantity(), "", true);
+	}
+	for (auto& o : _orderBook.GetOfferStack())
+	{
+		if (o.GetQuantity() > 0) _book.Rest(false, ToTick(o.GetPrice()), o.GetQuantity(), "", true);
+	}
+}
+
+/**
+* Matching Engine Listener loading market data into the engine as external liquidity.
+* Type T is the product type.
+* N is the book depth.
+*/
+template<typename T, size_t N>
+class MatchingEngineToMarketDataListener : public ServiceListener<OrderBook<T, N>>
+{
+
+private:
+
+	MatchingEngine<T>* service;
+
+public:
+
+	// Connector and Destructor
+	MatchingEngineToMarketDataListener(MatchingEngine<T>* _service);
+	~MatchingEngineToMarketDataListener();
+
+	// Listener callback to process an add event to the Service
+	void ProcessAdd(OrderBook<T, N>& _data);
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(OrderBook<T, N>& _data);
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(OrderBook<T, N>& _data);
+
+};
+
+template<typename T, size_t N>
+MatchingEngineToMarketDataListener<T, N>::MatchingEngineToMarketDataListener(MatchingEngine<T>* _service)
+{
+	service = _service;
+}
+
+template<typename T, size_t N>
+MatchingEngineToMarketDataListener<T, N>::~MatchingEngineToMarketDataListener() {}
+
+template<typename T, size_t N>
+void MatchingEngineToMarketDataListener<T, N>::ProcessAdd(OrderBook<T, N>& _data)
+{
+	service->LoadBook(_data);
+}
+
+template<typename T, size_t N>
+void MatchingEngineToMarketDataListener<T, N>::ProcessRemove(OrderBook<T, N>& _data) {}
+
+template<typename T, size_t N>
+void MatchingEngineToMarketDataListener<T, N>::ProcessUpdate(OrderBook<T, N>& _data) {}
+
+#endif
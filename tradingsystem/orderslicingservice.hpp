@@ -0,0 +1,581 @@
+/**
+* orderslicingservice.hpp
+* Defines the data types and Service for slicing parent orders into child orders.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef ORDER_SLICING_SERVICE_HPP
+#define ORDER_SLICING_SERVICE_HPP
+
+#include <string>
+#include <vector>
+#include <queue>
+#include <functional>
+#include "soa.hpp"
+#include "algoexecutionservice.hpp"
+
+using namespace std;
+
+enum SliceType { TWAP, VWAP, ICEBERG };
+
+/**
+* A parent order held by the slicing service and worked through child orders.
+* TWAP sends equal slices at every interval until the end time.
+* VWAP sends a participation rate of the market volume seen in each interval.
+* ICEBERG shows the display quantity and refills it each time it is filled.
+* Quantity left on a cancelled or rejected child goes back to the parent unsent.
+* Times are in microseconds since epoch.
+* Type T is the product type.
+*/
+template<typename T>
+class ParentOrder
+{
+
+public:
+
+	// ctor for a parent order
+	ParentOrder() = default;
+	ParentOrder(const T& _product, string _parentOrderId, PricingSide _side, SliceType _sliceType, OrderType _orderType, double _price, long _quantity, long long _startTime, long long _endTime, long long _interval, long _displayQuantity, double _participationRate);
+
+	// Get the product
+	const T& GetProduct() const;
+
+	// Get the parent order ID
+	const string& GetParentOrderId() const;
+
+	// Get the pricing side
+	PricingSide GetPricingSide() const;
+
+	// Get the slicing type
+	SliceType GetSliceType() const;
+
+	// Get the order type of the child orders
+	OrderType GetOrderType() const;
+
+	// Get the limit price of the child orders
+	double GetPrice() const;
+
+	// Get the total quantity
+	long GetQuantity() const;
+
+	// Get the quantity not yet sent in a child order
+	long GetUnsentQuantity() const;
+
+	// Get the quantity filled so far
+	long GetFilledQuantity() const;
+
+	// Get the start time
+	long long GetStartTime() const;
+
+	// Get the end time
+	long long GetEndTime() const;
+
+	// Get the interval between slices
+	long long GetInterval() const;
+
+	// Get the display quantity of an iceberg
+	long GetDisplayQuantity() const;
+
+	// Get the participation rate of a VWAP order
+	double GetParticipationRate() const;
+
+	// Record a quantity sent in a child order
+	void AddSent(long _quantity);
+
+	// Record a quantity filled on a child order
+	void AddFilled(long _quantity);
+
+	// Record a quantity cancelled on a child order, to be sent again
+	void AddCancelled(long _quantity);
+
+	// Is the whole quantity filled?
+	bool IsDone() const;
+
+private:
+	T product;
+	string parentOrderId;
+	PricingSide side;
+	SliceType sliceType;
+	OrderType orderType;
+	double price;
+	long quantity;
+	long unsentQuantity;
+	long filledQuantity;
+	long long startTime;
+	long long endTime;
+	long long interval;
+	long displayQuantity;
+	double participationRate;
+
+};
+
+template<typename T>
+ParentOrder<T>::ParentOrder(const T& _product, string _parentOrderId, PricingSide _side, SliceType _sliceType, OrderType _orderType, double _price, long _quantity, long long _startTime, long long _endTime, long long _interval, long _displayQuantity, double _participationRate) :
+	product(_product)
+{
+	parentOrderId = _parentOrderId;
+	side = _side;
+	sliceType = _sliceType;
+	orderType = _orderType;
+	price = _price;
+	quantity = _quantity;
+	unsentQuantity = _quantity;
+	filledQuantity = 0;
+	startTime = _startTime;
+	endTime = _endTime;
+	interval = _interval;
+	displayQuantity = _displayQuantity;
+	participationRate = _participationRate;
+}
+
+template<typename T>
+const T& ParentOrder<T>::GetProduct() const
+{
+	return product;
+}
+
+template<typename T>
+const string& ParentOrder<T>::GetParentOrderId() const
+{
+	return parentOrderId;
+}
+
+template<typename T>
+PricingSide ParentOrder<T>::GetPricingSide() const
+{
+	return side;
+}
+
+template<typename T>
+SliceType ParentOrder<T>::GetSliceType() const
+{
+	return sliceType;
+}
+
+template<typename T>
+OrderType ParentOrder<T>::GetOrderType() const
+{
+	return orderType;
+}
+
+template<typename T>
+double ParentOrder<T>::GetPrice() const
+{
+	return price;
+}
+
+template<typename T>
+long ParentOrder<T>::GetQuantity() const
+{
+	return quantity;
+}
+
+template<typename T>
+long ParentOrder<T>::GetUnsentQuantity() const
+{
+	return unsentQuantity;
+}
+
+template<typename T>
+long ParentOrder<T>::GetFilledQuantity() const
+{
+	return filledQuantity;
+}
+
+template<typename T>
+long long ParentOrder<T>::GetStartTime() const
+{
+	return startTime;
+}
+
+template<typename T>
+long long ParentOrder<T>::GetEndTime() const
+{
+	return endTime;
+}
+
+template<typename T>
+long long ParentOrder<T>::GetInterval() const
+{
+	return interval;
+}
+
+template<typename T>
+long ParentOrder<T>::GetDisplayQuantity() const
+{
+	return displayQuantity;
+}
+
+template<typename T>
+double ParentOrder<T>::GetParticipationRate() const
+{
+	return participationRate;
+}
+
+template<typename T>
+void ParentOrder<T>::AddSent(long _quantity)
+{
+	unsentQuantity -= _quantity;
+}
+
+template<typename T>
+void ParentOrder<T>::AddFilled(long _quantity)
+{
+	filledQuantity += _quantity;
+}
+
+template<typename T>
+void ParentOrder<T>::AddCancelled(long _quantity)
+{
+	unsentQuantity += _quantity;
+}
+
+template<typename T>
+bool ParentOrder<T>::IsDone() const
+{
+	return filledQuantity >= quantity;
+}
+
+/**
+* Pre-declearations to avoid errors.
+*/
+template<typename T>
+class OrderSlicingToExecutionListener;
+
+/**
+* Order Slicing Service holding parent orders and sending child orders on a schedule.
+* All parent orders share one timer queue ordered by their next slice time, so the
+* cost of a timer tick depends on the slices due rather than the number of parents.
+* A TWAP or VWAP parent stays on the timer queue until it is filled, so quantity
+* coming back from cancelled children is sliced again. An iceberg whose clip is
+* cancelled shows a new clip at a later timer tick, not at once, so a clip the
+* venue keeps cancelling does not loop.
+* Keyed on product identifier.
+* Type T is the product type.
+*/
+template<typename T>
+class OrderSlicingService : public Service<string, AlgoExecution<T>>
+{
+
+private:
+
+	map<string, AlgoExecution<T>> algoExecutions;
+	vector<ServiceListener<AlgoExecution<T>>*> listeners;
+	OrderSlicingToExecutionListener<T>* listener;
+	map<string, ParentOrder<T>> parentOrders;
+	map<string, long> childCounts;
+	unordered_map<string, pair<string, long>> childOrders;
+	unordered_map<string, long> marketVolumes;
+	unordered_map<string, long> participatedVolumes;
+	priority_queue<pair<long long, string>, vector<pair<long long, string>>, greater<pair<long long, string>>> timers;
+	long long timerTime;
+
+	// Send a child order for a parent order
+	void SendChild(ParentOrder<T>& _parentOrder, long _quantity);
+
+	// Work a parent order at a timer tick and reschedule it
+	void Slice(ParentOrder<T>& _parentOrder, long long _time);
+
+public:
+
+	// Constructor and destructor
+	OrderSlicingService();
+	~OrderSlicingService();
+
+	// Get data on our service given a key
+	AlgoExecution<T>& GetData(string _key);
+
+	// The callback that a Connector should invoke for any new or updated data
+	void OnMessage(AlgoExecution<T>& _data);
+
+	// Add a listener to the Service for callbacks on add, remove, and update events for data to the Service
+	void AddListener(ServiceListener<AlgoExecution<T>>* _listener);
+
+	// Get all listeners on the Service
+	const vector<ServiceListener<AlgoExecution<T>>*>& GetListeners() const;
+
+	// Get the listener of the service
+	OrderSlicingToExecutionListener<T>* GetListener();
+
+	// Add a parent order to be sliced, rejecting a TWAP or VWAP order without a positive interval
+	bool AddParentOrder(const ParentOrder<T>& _parentOrder);
+
+	// Get a parent order
+	const ParentOrder<T>& GetParentOrder(const string& _parentOrderId);
+
+	// Get the number of parent orders being worked
+	long GetParentOrderCount() const;
+
+	// Record market volume traded in a product, for VWAP participation
+	void AddMarketVolume(const string& _productId, long _volume);
+
+	// Fire every slice due at or before a time
+	void OnTimer(long long _time);
+
+	// Record a fill on a child order
+	void ProcessFill(ExecutionOrder<T>& _executionOrder);
+
+	// Return the quantity of a cancelled or rejected child order to its parent
+	void ProcessCancel(ExecutionOrder<T>& _executionOrder);
+
+};
+
+template<typename T>
+OrderSlicingService<T>::OrderSlicingService()
+{
+	algoExecutions = map<string, AlgoExecution<T>>();
+	listeners = vector<ServiceListener<AlgoExecution<T>>*>();
+	listener = new OrderSlicingToExecutionListener<T>(this);
+	parentOrders = map<string, ParentOrder<T>>();
+	childCounts = map<string, long>();
+	timerTime = 0;
+}
+
+template<typename T>
+OrderSlicingService<T>::~OrderSlicingService() {}
+
+template<typename T>
+AlgoExecution<T>& OrderSlicingService<T>::GetData(string _key)
+{
+	return algoExecutions[_key];
+}
+
+template<typename T>
+void OrderSlicingService<T>::OnMessage(AlgoExecution<T>& _data)
+{
+	algoExecutions[_data.GetExecutionOrder()->GetProduct().GetProductId()] = _data;
+}
+
+template<typename T>
+void OrderSlicingService<T>::AddListener(ServiceListener<AlgoExecution<T>>* _listener)
+{
+	listeners.push_back(_listener);
+}
+
+template<typename T>
+const vector<ServiceListener<AlgoExecution<T>>*>& OrderSlicingService<T>::GetListeners() const
+{
+	return listeners;
+}
+
+template<typename T>
+OrderSlicingToExecutionListener<T>* OrderSlicingService<T>::GetListener()
+{
+	return listener;
+}
+
+template<typename T>
+bool OrderSlicingService<T>::AddParentOrder(const ParentOrder<T>& _parentOrder)
+{
+	if (_parentOrder.GetSliceType() != ICEBERG && _parentOrder.GetInterval() <= 0) return false;
+	const string& _parentOrderId = _parentOrder.GetParentOrderId();
+	ParentOrder<T>& _parent = parentOrders[_parentOrderId] = _parentOrder;
+	childCounts[_parentOrderId] = 0;
+
+	// An iceberg shows its first clip at once; the other types wait for their first slice.
+	if (_parent.GetSliceType() == ICEBERG)
+	{
+		SendChild(_parent, min(_parent.GetDisplayQuantity(), _parent.GetUnsentQuantity()));
+	}
+	else
+	{
+		if (_parent.GetSliceType() == VWAP) participatedVolumes[_parentOrderId] = marketVolumes[_parent.GetProduct().GetProductId()];
+		timers.push(make_pair(_parent.GetStartTime(), _parentOrderId));
+	}
+	return true;
+}
+
+template<typename T>
+const ParentOrder<T>& OrderSlicingService<T>::GetParentOrder(const string& _parentOrderId)
+{
+	return parentOrders[_parentOrderId];
+}
+
+template<typename T>
+long OrderSlicingService<T>::GetParentOrderCount() const
+{
+	return parentOrders.size();
+}
+
+template<typename T>
+void OrderSlicingService<T>::AddMarketVolume(const string& _productId, long _volume)
+{
+	marketVolumes[_productId] += _volume;
+}
+
+template<typename T>
+void OrderSlicingService<T>::OnTimer(long long _time)
+{
+	timerTime = _time;
+	while (!timers.empty() && timers.top().first <= _time)
+	{
+		string _parentOrderId = timers.top().second;
+		timers.pop();
+		auto _iter = parentOrders.find(_parentOrderId);
+		if (_iter == parentOrders.end()) continue;
+		Slice(_iter->second, _time);
+	}
+}
+
+template<typename T>
+void OrderSlicingService<T>::Slice(ParentOrder<T>& _parentOrder, long long _time)
+{
+	long _unsent = _parentOrder.GetUnsentQuantity();
+	long _quantity = 0;
+	long long _interval = _parentOrder.GetInterval();
+	switch (_parentOrder.GetSliceType())
+	{
+	case TWAP:
+	{
+		// Spread what is left evenly over the slices left, sending all of it at the end time.
+		long long _slicesLeft = (_parentOrder.GetEndTime() - _time) / _interval + 1;
+		if (_slicesLeft < 1) _slicesLeft = 1;
+		_quantity = (long)((_unsent + _slicesLeft - 1) / _slicesLeft);
+		break;
+	}
+	case VWAP:
+	{
+		const string& _parentOrderId = _parentOrder.GetParentOrderId();
+		long _volume = marketVolumes[_parentOrder.GetProduct().GetProductId()];
+		long& _participated = participatedVolumes[_parentOrderId];
+		_quantity = (long)((_volume - _participated) * _parentOrder.GetParticipationRate());
+		_participated = _volume;
+		if (_time >= _parentOrder.GetEndTime()) _quantity = _unsent;
+		break;
+	}
+	case ICEBERG:
+		// A new clip is shown only when no clip is left on the market.
+		if (_parentOrder.GetFilledQuantity() + _unsent == _parentOrder.GetQuantity()) _quantity = min(_parentOrder.GetDisplayQuantity(), _unsent);
+		break;
+	}
+
+	// Reschedule before sending, since a child filled at once can complete and remove the parent.
+	if (_quantity > _unsent) _quantity = _unsent;
+	if (_parentOrder.GetSliceType() != ICEBERG) timers.push(make_pair(_time + _interval, _parentOrder.GetParentOrderId()));
+	if (_quantity > 0) SendChild(_parentOrder, _quantity);
+}
+
+template<typename T>
+void OrderSlicingService<T>::SendChild(ParentOrder<T>& _parentOrder, long _quantity)
+{
+	const string& _parentOrderId = _parentOrder.GetParentOrderId();
+	const T& _product = _parentOrder.GetProduct();
+	string _childOrderId = _parentOrderId + "-" + to_string(++childCounts[_parentOrderId]);
+	childOrders[_childOrderId] = make_pair(_parentOrderId, _quantity);
+	_parentOrder.AddSent(_quantity);
+
+	AlgoExecution<T> _algoExecution(_product, _parentOrder.GetPricingSide(), _childOrderId, _parentOrder.GetOrderType(), _parentOrder.GetPrice(), _quantity, 0, _parentOrderId, true);
+	algoExecutions[_product.GetProductId()] = _algoExecution;
+
+	for (auto& l : listeners)
+	{
+		l->ProcessAdd(_algoExecution);
+	}
+}
+
+template<typename T>
+void OrderSlicingService<T>::ProcessFill(ExecutionOrder<T>& _executionOrder)
+{
+	if (!_executionOrder.IsChildOrder()) return;
+	auto _childIter = childOrders.find(_executionOrder.GetOrderId());
+	if (_childIter == childOrders.end()) return;
+	auto _parentIter = parentOrders.find(_childIter->second.first);
+	long _filled = _executionOrder.GetVisibleQuantity() + _executionOrder.GetHiddenQuantity();
+	_childIter->second.second -= _filled;
+	if (_childIter->second.second <= 0) childOrders.erase(_childIter);
+	if (_parentIter == parentOrders.end()) return;
+
+	ParentOrder<T>& _parentOrder = _parentIter->second;
+	_parentOrder.AddFilled(_filled);
+
+	if (_parentOrder.IsDone())
+	{
+		string _parentOrderId = _parentOrder.GetParentOrderId();
+		parentOrders.erase(_parentIter);
+		childCounts.erase(_parentOrderId);
+		participatedVolumes.erase(_parentOrderId);
+		return;
+	}
+
+	// An iceberg refills its visible clip once the clip on the market has been filled.
+	if (_parentOrder.GetSliceType() == ICEBERG && _parentOrder.GetFilledQuantity() + _parentOrder.GetUnsentQuantity() == _parentOrder.GetQuantity() && _parentOrder.GetUnsentQuantity() > 0)
+	{
+		SendChild(_parentOrder, min(_parentOrder.GetDisplayQuantity(), _parentOrder.GetUnsentQuantity()));
+	}
+}
+
+template<typename T>
+void OrderSlicingService<T>::ProcessCancel(ExecutionOrder<T>& _executionOrder)
+{
+	if (!_executionOrder.IsChildOrder()) return;
+	auto _childIter = childOrders.find(_executionOrder.GetOrderId());
+	if (_childIter == childOrders.end()) return;
+	auto _parentIter = parentOrders.find(_childIter->second.first);
+	long _cancelled = min(_executionOrder.GetVisibleQuantity() + _executionOrder.GetHiddenQuantity(), _childIter->second.second);
+	_childIter->second.second -= _cancelled;
+	if (_childIter->second.second <= 0) childOrders.erase(_childIter);
+	if (_parentIter == parentOrders.end() || _cancelled <= 0) return;
+
+	ParentOrder<T>& _parentOrder = _parentIter->second;
+	_parentOrder.AddCancelled(_cancelled);
+	if (_parentOrder.GetSliceType() == ICEBERG)
+	{
+		timers.push(make_pair(timerTime + max(_parentOrder.GetInterval(), 1LL), _parentOrder.GetParentOrderId()));
+	}
+}
+
+/**
+* Order Slicing Service Listener subscribing child order fills from Execution Service.
+* Type T is the product type.
+*/
+template<typename T>
+class OrderSlicingToExecutionListener : public ServiceListener<ExecutionOrder<T>>
+{
+
+private:
+
+	OrderSlicingService<T>* service;
+
+public:
+
+	// Connector and Destructor
+	OrderSlicingToExecutionListener(OrderSlicingService<T>* _service);
+	~OrderSlicingToExecutionListener();
+
+	// Listener callback to process an add event to the Service
+	void ProcessAdd(ExecutionOrder<T>& _data);
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(ExecutionOrder<T>& _data);
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(ExecutionOrder<T>& _data);
+
+};
+
+template<typename T>
+OrderSlicingToExecutionListener<T>::OrderSlicingToExecutionListener(OrderSlicingService<T>* _service)
+{
+	service = _service;
+}
+
+template<typename T>
+OrderSlicingToExecutionListener<T>::~OrderSlicingToExecutionListener() {}
+
+template<typename T>
+void OrderSlicingToExecutionListener<T>::ProcessAdd(ExecutionOrder<T>& _data)
+{
+	service->ProcessFill(_data);
+}
+
+template<typename T>
+void OrderSlicingToExecutionListener<T>::ProcessRemove(ExecutionOrder<T>& _data)
+{
+	service->ProcessCancel(_data);
+}
+
+template<typename T>
+void OrderSlicingToExecutionListener<T>::ProcessUpdate(ExecutionOrder<T>& _data) {}
+
+#endif
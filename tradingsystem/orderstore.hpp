@@ -0,0 +1,491 @@
+/**
+* orderstore.hpp
+* Defines an order store keyed by order identifier with an order state machine.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef ORDER_STORE_HPP
+#define ORDER_STORE_HPP
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <unordered_map>
+#include "algoexecutionservice.hpp"
+
+using namespace std;
+
+enum OrderState { ORDER_NEW, ORDER_ACKED, ORDER_PARTIALLY_FILLED, ORDER_FILLED, ORDER_CANCELLED };
+
+/**
+* Order store keeping the lifecycle of execution orders by order identifier.
+* Orders live in a fixed pool of slots allocated up front. An open-addressing
+* index with linear probing maps order identifiers to slots, and the open orders
+* of each product are chained through their slots, so lookup, amend, cancel and
+* fills are O(1) and do not allocate.
+* State moves NEW -> ACKED -> PARTIALLY_FILLED -> FILLED, and any open state can
+* move to CANCELLED. FILLED and CANCELLED are terminal.
+* Type T is the product type.
+*/
+template<typename T>
+class OrderStore
+{
+
+public:
+
+	// Longest order identifier the store keeps
+	static const int MAX_ORDER_ID = 31;
+
+	// ctor for an order store
+	OrderStore(long _capacity = 65536);
+
+	// Get the number of orders in the store
+	long GetSize() const;
+
+	// Get the number of slots in the store
+	long GetCapacity() const;
+
+	// Add a new order and return its slot, or -1 if the store is full, the ID is taken or too long
+	long AddOrder(const ExecutionOrder<T>& _order);
+
+	// Get the slot of an order, or -1 if it is not in the store
+	long FindOrder(const string& _orderId) const;
+
+	// Acknowledge a new order
+	bool AckOrder(const string& _orderId);
+
+	// Fill a quantity on an open order
+	bool FillOrder(const string& _orderId, long _quantity);
+
+	// Amend the price and open quantity of an open order
+	bool AmendOrder(const string& _orderId, double _price, long _quantity);
+
+	// Cancel an open order
+	bool CancelOrder(const string& _orderId);
+
+	// Remove an order from the store and free its slot
+	bool ReleaseOrder(const string& _orderId);
+
+	// Get the state of an order in a slot
+	OrderState GetState(long _slot) const;
+
+	// Get the order identifier in a slot
+	string GetOrderId(long _slot) const;
+
+	// Get the product of an order in a slot
+	const T& GetProduct(long _slot) const;
+
+	// Get the side of an order in a slot
+	PricingSide GetPricingSide(long _slot) const;
+
+	// Get the order type of an order in a slot
+	OrderType GetOrderType(long _slot) const;
+
+	// Get the parent order identifier of an order in a slot
+	string GetParentOrderId(long _slot) const;
+
+	// Is the order in a slot a child order?
+	bool IsChildOrder(long _slot) const;
+
+	// Get the price of an order in a slot
+	double GetPrice(long _slot) const;
+
+	// Get the open quantity of an order in a slot
+	long GetLeavesQuantity(long _slot) const;
+
+	// Get the filled quantity of an order in a slot
+	long GetFilledQuantity(long _slot) const;
+
+	// Get the first open order slot of a product, or -1 if there is none
+	long GetFirstOpenOrder(const string& _productId) const;
+
+	// Get the next open order slot of the same product, or -1 at the end
+	long GetNextOpenOrder(long _slot) const;
+
+	// Get the number of open orders of a product
+	long GetOpenOrderCount(const string& _productId) const;
+
+	// Is a state transition allowed?
+	static bool CanTransition(OrderState _from, OrderState _to);
+
+private:
+
+	struct Slot
+	{
+		char orderId[MAX_ORDER_ID + 1];
+		unsigned int orderIdLength;
+		unsigned int hash;
+		char parentOrderId[MAX_ORDER_ID + 1];
+		unsigned int parentOrderIdLength;
+		bool isChildOrder;
+		int product;
+		PricingSide side;
+		OrderType orderType;
+		OrderState state;
+		double price;
+		long leavesQuantity;
+		long filledQuantity;
+		long prevOpen;
+		long nextOpen;
+		long nextFree;
+	};
+
+	vector<Slot> slots;
+	vector<long> index;
+	unsigned long indexMask;
+	long freeHead;
+	long size;
+
+	unordered_map<string, int> productIndexes;
+	vector<T> products;
+	vector<long> openHeads;
+	vector<long> openCounts;
+
+	// Hash an order identifier
+	static unsigned int Hash(const char* _orderId, size_t _length);
+
+	// Find the index position holding an order identifier, or -1
+	long FindPosition(const char* _orderId, size_t _length, unsigned int _hash) const;
+
+	// Get the product index of a product, adding it if new
+	int GetProductIndex(const T& _product);
+
+	// Link a slot into the open orders of its product
+	void LinkOpen(long _slot);
+
+	// Unlink a slot from the open orders of its product
+	void UnlinkOpen(long _slot);
+
+	// Move an order to a new state if the state machine allows it
+	bool Transition(long _slot, OrderState _state);
+
+};
+
+template<typename T>
+OrderStore<T>::OrderStore(long _capacity)
+{
+	slots = vector<Slot>(_capacity);
+	for (long i = 0; i < _capacity; i++)
+	{
+		slots[i].nextFree = i + 1 < _capacity ? i + 1 : -1;
+	}
+	freeHead = _capacity > 0 ? 0 : -1;
+	size = 0;
+
+	// Keep the index at most half full so probe chains stay short.
+	unsigned long _indexSize = 1;
+	while (_indexSize < (unsigned long)_capacity * 2) _indexSize <<= 1;
+	index = vector<long>(_indexSize, -1);
+	indexMask = _indexSize - 1;
+
+	productIndexes = unordered_map<string, int>();
+	products = vector<T>();
+	openHeads = vector<long>();
+	openCounts = vector<long>();
+}
+
+template<typename T>
+long OrderStore<T>::GetSize() const
+{
+	return size;
+}
+
+template<typename T>
+long OrderStore<T>::GetCapacity() const
+{
+	return slots.size();
+}
+
+template<typename T>
+unsigned int OrderStore<T>::Hash(const char* _orderId, size_t _length)
+{
+	unsigned int _hash = 2166136261u;
+	for (size_t i = 0; i < _length; i++)
+	{
+		_hash ^= (unsigned char)_orderId[i];
+		_hash *= 16777619u;
+	}
+	return _hash;
+}
+
+template<typename T>
+long OrderStore<T>::FindPosition(const char* _orderId, size_t _length, unsigned int _hash) const
+{
+	unsigned long _position = _hash & indexMask;
+	while (index[_position] >= 0)
+	{
+		const Slot& _slot = slots[index[_position]];
+		if (_slot.hash == _hash && _slot.orderIdLength == _length && memcmp(_slot.orderId, _orderId, _length) == 0) return _position;
+		_position = (_position + 1) & indexMask;
+	}
+	return -1;
+}
+
+template<typename T>
+int OrderStore<T>::GetProductIndex(const T& _product)
+{
+	const string& _productId = _product.GetProductId();
+	auto _iter = productIndexes.find(_productId);
+	if (_iter != productIndexes.end()) return _iter->second;
+	int _index = products.size();
+	productIndexes[_productId] = _index;
+	products.push_back(_product);
+	openHeads.push_back(-1);
+	openCounts.push_back(0);
+	return _index;
+}
+
+template<typename T>
+void OrderStore<T>::LinkOpen(long _slot)
+{
+	Slot& _s = slots[_slot];
+	_s.prevOpen = -1;
+	_s.nextOpen = openHeads[_s.product];
+	if (_s.nextOpen >= 0) slots[_s.nextOpen].prevOpen = _slot;
+	openHeads[_s.product] = _slot;
+	openCounts[_s.product]++;
+}
+
+template<typename T>
+void OrderStore<T>::UnlinkOpen(long _slot)
+{
+	Slot& _s = slots[_slot];
+	if (_s.prevOpen >= 0) slots[_s.prevOpen].nextOpen = _s.nextOpen;
+	else openHeads[_s.product] = _s.nextOpen;
+	if (_s.nextOpen >= 0) slots[_s.nextOpen].prevOpen = _s.prevOpen;
+	_s.prevOpen = -1;
+	_s.nextOpen = -1;
+	openCounts[_s.product]--;
+}
+
+template<typename T>
+bool OrderStore<T>::CanTransition(OrderState _from, OrderState _to)
+{
+	switch (_from)
+	{
+	case ORDER_NEW:
+		return _to == ORDER_ACKED || _to == ORDER_PARTIALLY_FILLED || _to == ORDER_FILLED || _to == ORDER_CANCELLED;
+	case ORDER_ACKED:
+		return _to == ORDER_PARTIALLY_FILLED || _to == ORDER_FILLED || _to == ORDER_CANCELLED;
+	case ORDER_PARTIALLY_FILLED:
+		return _to == ORDER_PARTIALLY_FILLED || _to == ORDER_FILLED || _to == ORDER_CANCELLED;
+	default:
+		return false;
+	}
+}
+
+template<typename T>
+bool OrderStore<T>::Transition(long _slot, OrderState _state)
+{
+	Slot& _s = slots[_slot];
+	if (!CanTransition(_s.state, _state)) return false;
+	_s.state = _state;
+	if (_state == ORDER_FILLED || _state == ORDER_CANCELLED) UnlinkOpen(_slot);
+	return true;
+}
+
+template<typename T>
+long OrderStore<T>::AddOrder(const ExecutionOrder<T>& _order)
+{
+	const string& _orderId = _order.GetOrderId();
+	const string& _parentOrderId = _order.GetParentOrderId();
+	size_t _length = _orderId.size();
+	if (freeHead < 0 || _length > MAX_ORDER_ID || _parentOrderId.size() > MAX_ORDER_ID) return -1;
+	unsigned int _hash = Hash(_orderId.data(), _length);
+	if (FindPosition(_orderId.data(), _length, _hash) >= 0) return -1;
+
+	long _slot = freeHead;
+	Slot& _s = slots[_slot];
+	freeHead = _s.nextFree;
+	memcpy(_s.orderId, _orderId.data(), _length);
+	_s.orderId[_length] = '\0';
+	_s.orderIdLength = _length;
+	_s.hash = _hash;
+	memcpy(_s.parentOrderId, _parentOrderId.data(), _parentOrderId.size());
+	_s.parentOrderId[_parentOrderId.size()] = '\0';
+	_s.parentOrderIdLength = _parentOrderId.size();
+	_s.isChildOrder = _order.IsChildOrder();
+	_s.product = GetProductIndex(_order.GetProduct());
+	_s.side = _order.GetPricingSide();
+	_s.orderType = _order.GetOrderType();
+	_s.state = ORDER_NEW;
+	_s.price = _order.GetPrice();
+	_s.leavesQuantity = _order.GetVisibleQuantity() + _order.GetHiddenQuantity();
+	_s.filledQuantity = 0;
+	_s.nextFree = -1;
+	LinkOpen(_slot);
+
+	unsigned long _position = _hash & indexMask;
+	while (index[_position] >= 0) _position = (_position + 1) & indexMask;
+	index[_position] = _slot;
+	size++;
+	return _slot;
+}
+
+template<typename T>
+long OrderStore<T>::FindOrder(const string& _orderId) const
+{
+	unsigned int _hash = Hash(_orderId.data(), _orderId.size());
+	long _position = FindPosition(_orderId.data(), _orderId.size(), _hash);
+	return _position < 0 ? -1 : index[_position];
+}
+
+template<typename T>
+bool OrderStore<T>::AckOrder(const string& _orderId)
+{
+	long _slot = FindOrder(_orderId);
+	if (_slot < 0) return false;
+	return Transition(_slot, ORDER_ACKED);
+}
+
+template<typename T>
+bool OrderStore<T>::FillOrder(const string& _orderId, long _quantity)
+{
+	long _slot = FindOrder(_orderId);
+	if (_slot < 0) return false;
+	Slot& _s = slots[_slot];
+	if (_quantity <= 0 || _quantity > _s.leavesQuantity) return false;
+	OrderState _state = _quantity == _s.leavesQuantity ? ORDER_FILLED : ORDER_PARTIALLY_FILLED;
+	if (!Transition(_slot, _state)) return false;
+	_s.leavesQuantity -= _quantity;
+	_s.filledQuantity += _quantity;
+	return true;
+}
+
+template<typename T>
+bool OrderStore<T>::AmendOrder(const string& _orderId, double _price, long _quantity)
+{
+	long _slot = FindOrder(_orderId);
+	if (_slot < 0) return false;
+	Slot& _s = slots[_slot];
+	if (_s.state == ORDER_FILLED || _s.state == ORDER_CANCELLED || _quantity <= 0) return false;
+	_s.price = _price;
+	_s.leavesQuantity = _quantity;
+	return true;
+}
+
+template<typename T>
+bool OrderStore<T>::CancelOrder(const string& _orderId)
+{
+	long _slot = FindOrder(_orderId);
+	if (_slot < 0) return false;
+	if (!Transition(_slot, ORDER_CANCELLED)) return false;
+	slots[_slot].leavesQuantity = 0;
+	return true;
+}
+
+template<typename T>
+bool OrderStore<T>::ReleaseOrder(const string& _orderId)
+{
+	unsigned int _hash = Hash(_orderId.data(), _orderId.size());
+	long _position = FindPosition(_orderId.data(), _orderId.size(), _hash);
+	if (_position < 0) return false;
+	long _slot = index[_position];
+	Slot& _s = slots[_slot];
+	if (_s.state != ORDER_FILLED && _s.state != ORDER_CANCELLED) UnlinkOpen(_slot);
+
+	// Backward shift deletion keeps probe chains intact without tombstones.
+	unsigned long _hole = _position;
+	unsigned long _next = (_hole + 1) & indexMask;
+	while (index[_next] >= 0)
+	{
+		unsigned long _home = slots[index[_next]].hash & indexMask;
+		if (((_next - _home) & indexMask) >= ((_next - _hole) & indexMask))
+		{
+			index[_hole] = index[_next];
+			_hole = _next;
+		}
+		_next = (_next + 1) & indexMask;
+	}
+	index[_hole] = -1;
+
+	_s.nextFree = freeHead;
+	freeHead = _slot;
+	size--;
+	return true;
+}
+
+template<typename T>
+OrderState OrderStore<T>::GetState(long _slot) const
+{
+	return slots[_slot].state;
+}
+
+template<typename T>
+string OrderStore<T>::GetOrderId(long _slot) const
+{
+	return string(slots[_slot].orderId, slots[_slot].orderIdLength);
+}
+
+template<typename T>
+const T& OrderStore<T>::GetProduct(long _slot) const
+{
+	return products[slots[_slot].product];
+}
+
+template<typename T>
+PricingSide OrderStore<T>::GetPricingSide(long _slot) const
+{
+	return slots[_slot].side;
+}
+
+template<typename T>
+OrderType OrderStore<T>::GetOrderType(long _slot) const
+{
+	return slots[_slot].orderType;
+}
+
+template<typename T>
+string OrderStore<T>::GetParentOrderId(long _slot) const
+{
+	return string(slots[_slot].parentOrderId, slots[_slot].parentOrderIdLength);
+}
+
+template<typename T>
+bool OrderStore<T>::IsChildOrder(long _slot) const
+{
+	return slots[_slot].isChildOrder;
+}
+
+template<typename T>
+double OrderStore<T>::GetPrice(long _slot) const
+{
+	return slots[_slot].price;
+}
+
+template<typename T>
+long OrderStore<T>::GetLeavesQuantity(long _slot) const
+{
+	return slots[_slot].leavesQuantity;
+}
+
+template<typename T>
+long OrderStore<T>::GetFilledQuantity(long _slot) const
+{
+	return slots[_slot].filledQuantity;
+}
+
+template<typename T>
+long OrderStore<T>::GetFirstOpenOrder(const string& _productId) const
+{
+	auto _iter = productIndexes.find(_productId);
+	if (_iter == productIndexes.end()) return -1;
+	return openHeads[_iter->second];
+}
+
+template<typename T>
+long OrderStore<T>::GetNextOpenOrder(long _slot) const
+{
+	return slots[_slot].nextOpen;
+}
+
+template<typename T>
+long OrderStore<T>::GetOpenOrderCount(const string& _productId) const
+{
+	auto _iter = productIndexes.find(_productId);
+	if (_iter == productIndexes.end()) return 0;
+	return openCounts[_iter->second];
+}
+
+#endif
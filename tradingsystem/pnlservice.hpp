@@ -0,0 +1,563 @@
+/**
+* pnlservice.hpp
+* Defines the data types and Service for realized and unrealized PnL.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef PNL_SERVICE_HPP
+#define PNL_SERVICE_HPP
+
+#include <string>
+#include <map>
+#include <cstdlib>
+#include <algorithm>
+#include <unordered_map>
+#include "soa.hpp"
+#include "pricingservice.hpp"
+#include "tradebookingservice.hpp"
+
+using namespace std;
+
+/**
+* PnL of a product in a particular book.
+* Prices are per 100 face, so PnL is the quantity times the price move over 100.
+*/
+class BookPnL
+{
+
+public:
+
+	// ctor for a flat book
+	BookPnL();
+
+	// Get the position
+	long GetPosition() const;
+
+	// Get the average cost of the position
+	double GetAverageCost() const;
+
+	// Get the realized PnL
+	double GetRealizedPnL() const;
+
+	// Get the unrealized PnL at a mark price
+	double GetUnrealizedPnL(double _mark) const;
+
+	// Add a signed quantity traded at a price, and get the PnL it realized
+	double AddTrade(long _quantity, double _price);
+
+private:
+
+	long position;
+	double averageCost;
+	double realizedPnL;
+
+};
+
+BookPnL::BookPnL()
+{
+	position = 0;
+	averageCost = 0.0;
+	realizedPnL = 0.0;
+}
+
+long BookPnL::GetPosition() const
+{
+	return position;
+}
+
+double BookPnL::GetAverageCost() const
+{
+	return averageCost;
+}
+
+double BookPnL::GetRealizedPnL() const
+{
+	return realizedPnL;
+}
+
+double BookPnL::GetUnrealizedPnL(double _mark) const
+{
+	return position * (_mark - averageCost) / 100.0;
+}
+
+double BookPnL::AddTrade(long _quantity, double _price)
+{
+	// A trade of no quantity leaves the book as it is, and would divide the average cost by zero.
+	if (_quantity == 0) return 0.0;
+	if (position == 0 || (position > 0) == (_quantity > 0))
+	{
+		// Adding to the position moves the average cost toward the trade price.
+		averageCost = (averageCost * labs(position) + _price * labs(_quantity)) / (labs(position) + labs(_quantity));
+		position += _quantity;
+		return 0.0;
+	}
+
+	// Reducing the position realizes the closed part against the average cost.
+	long _closed = min(labs(_quantity), labs(position));
+	double _realizedPnL = (position > 0 ? _closed : -_closed) * (_price - averageCost) / 100.0;
+	realizedPnL += _realizedPnL;
+	long _previous = position;
+	position += _quantity;
+	if (position == 0) averageCost = 0.0;
+	else if ((position > 0) != (_previous > 0)) averageCost = _price;
+	return _realizedPnL;
+}
+
+/**
+* PnL of a product over its books.
+* The cost basis, the sum of each book position times its average cost, is kept
+* as trades come in, so marking the product to a new price is a single multiply
+* whatever the number of books.
+* Type T is the product type.
+*/
+template<typename T>
+class PnL
+{
+
+public:
+
+	// ctor for a PnL
+	PnL();
+	PnL(const T& _product);
+
+	// Get the product
+	const T& GetProduct() const;
+
+	// Get the PnL of the books
+	const map<string, BookPnL>& GetBooks() const;
+
+	// Get the position over books
+	long GetPosition() const;
+
+	// Get the mark price
+	double GetMark() const;
+
+	// Get the realized PnL over books
+	double GetRealizedPnL() const;
+
+	// Get the unrealized PnL over books at the mark price
+	double GetUnrealizedPnL() const;
+
+	// Add a signed quantity traded at a price in a book, and get the PnL it realized
+	double AddTrade(const string& _book, long _quantity, double _price);
+
+	// Mark the product to a price, and get the change in unrealized PnL
+	double Mark(double _mark);
+
+	// Revalue the unrealized PnL at the mark price, and get its change
+	double Revalue();
+
+	// Change attributes to strings
+	vector<string> ToStrings() const;
+
+private:
+
+	T product;
+	map<string, BookPnL> books;
+	long position;
+	double costBasis;
+	double mark;
+	bool marked;
+	double realizedPnL;
+	double unrealizedPnL;
+
+};
+
+template<typename T>
+PnL<T>::PnL()
+{
+	books = map<string, BookPnL>();
+	position = 0;
+	costBasis = 0.0;
+	mark = 0.0;
+	marked = false;
+	realizedPnL = 0.0;
+	unrealizedPnL = 0.0;
+}
+
+template<typename T>
+PnL<T>::PnL(const T& _product) :
+	product(_product)
+{
+	books = map<string, BookPnL>();
+	position = 0;
+	costBasis = 0.0;
+	mark = 0.0;
+	marked = false;
+	realizedPnL = 0.0;
+	unrealizedPnL = 0.0;
+}
+
+template<typename T>
+const T& PnL<T>::GetProduct() const
+{
+	return product;
+}
+
+template<typename T>
+const map<string, BookPnL>& PnL<T>::GetBooks() const
+{
+	return books;
+}
+
+template<typename T>
+long PnL<T>::GetPosition() const
+{
+	return position;
+}
+
+template<typename T>
+double PnL<T>::GetMark() const
+{
+	return mark;
+}
+
+template<typename T>
+double PnL<T>::GetRealizedPnL() const
+{
+	return realizedPnL;
+}
+
+template<typename T>
+double PnL<T>::GetUnrealizedPnL() const
+{
+	return unrealizedPnL;
+}
+
+template<typename T>
+double PnL<T>::Revalue()
+{
+	double _unrealizedPnL = marked ? (mark * position - costBasis) / 100.0 : 0.0;
+	double _change = _unrealizedPnL - unrealizedPnL;
+	unrealizedPnL = _unrealizedPnL;
+	return _change;
+}
+
+template<typename T>
+double PnL<T>::AddTrade(const string& _book, long _quantity, double _price)
+{
+	BookPnL& _bookPnL = books[_book];
+	costBasis -= _bookPnL.GetPosition() * _bookPnL.GetAverageCost();
+	position -= _bookPnL.GetPosition();
+	double _realizedPnL = _bookPnL.AddTrade(_quantity, _price);
+	costBasis += _bookPnL.GetPosition() * _bookPnL.GetAverageCost();
+	position += _bookPnL.GetPosition();
+	realizedPnL += _realizedPnL;
+	return _realizedPnL;
+}
+
+template<typename T>
+double PnL<T>::Mark(double _mark)
+{
+	mark = _mark;
+	marked = true;
+	return Revalue();
+}
+
+template<typename T>
+vector<string> PnL<T>::ToStrings() const
+{
+	vector<string> _strings;
+	_strings.push_back(product.GetProductId());
+	_strings.push_back(to_string(position));
+	_strings.push_back(to_string(realizedPnL));
+	_strings.push_back(to_string(unrealizedPnL));
+	for (auto& b : books)
+	{
+		_strings.push_back(b.first);
+		_strings.push_back(to_string(b.second.GetPosition()));
+		_strings.push_back(to_string(b.second.GetAverageCost()));
+		_strings.push_back(to_string(b.second.GetRealizedPnL()));
+	}
+	return _strings;
+}
+
+/**
+* Pre-declearations to avoid errors.
+*/
+template<typename T>
+class PnLToTradeBookingListener;
+template<typename T>
+class PnLToPricingListener;
+
+/**
+* PnL Service to keep realized and unrealized PnL across multiple books and securities.
+* Each trade updates the average cost and realized PnL of its product in its book,
+* and each price marks its product to the mid, so an update only touches the one
+* product. Desk totals move by the change of each update and are read in O(1).
+* Keyed on product identifier.
+* Type T is the product type.
+*/
+template<typename T>
+class PnLService : public Service<string, PnL<T>>
+{
+
+private:
+
+	unordered_map<string, PnL<T>> pnls;
+	vector<ServiceListener<PnL<T>>*> listeners;
+	PnLToTradeBookingListener<T>* tradeListener;
+	PnLToPricingListener<T>* pricingListener;
+	double realizedPnL;
+	double unrealizedPnL;
+
+	// Get the PnL of a product, adding it if it is new
+	PnL<T>& FindPnL(const T& _product);
+
+	// Publish the PnL of a product
+	void Publish(PnL<T>& _pnl);
+
+public:
+
+	// Constructor and destructor
+	PnLService();
+	~PnLService();
+
+	// Get data on our service given a key
+	PnL<T>& GetData(string _key);
+
+	// The callback that a Connector should invoke for any new or updated data
+	void OnMessage(PnL<T>& _data);
+
+	// Add a listener to the Service for callbacks on add, remove, and update events for data to the Service
+	void AddListener(ServiceListener<PnL<T>>* _listener);
+
+	// Get all listeners on the Service
+	const vector<ServiceListener<PnL<T>>*>& GetListeners() const;
+
+	// Get the listener of trades
+	PnLToTradeBookingListener<T>* GetTradeListener();
+
+	// Get the listener of prices
+	PnLToPricingListener<T>* GetPricingListener();
+
+	// Add a trade to the service
+	void AddTrade(const Trade<T>& _trade);
+
+	// Mark a product to a price
+	void AddPrice(const Price<T>& _price);
+
+	// Get the realized PnL of the desk
+	double GetRealizedPnL() const;
+
+	// Get the unrealized PnL of the desk
+	double GetUnrealizedPnL() const;
+
+	// Get the total PnL of the desk
+	double GetTotalPnL() const;
+
+};
+
+template<typename T>
+PnLService<T>::PnLService()
+{
+	pnls = unordered_map<string, PnL<T>>();
+	listeners = vector<ServiceListener<PnL<T>>*>();
+	tradeListener = new PnLToTradeBookingListener<T>(this);
+	pricingListener = new PnLToPricingListener<T>(this);
+	realizedPnL = 0.0;
+	unrealizedPnL = 0.0;
+}
+
+template<typename T>
+PnLService<T>::~PnLService() {}
+
+template<typename T>
+PnL<T>& PnLService<T>::GetData(string _key)
+{
+	return pnls[_key];
+}
+
+template<typename T>
+void PnLService<T>::OnMessage(PnL<T>& _data)
+{
+	PnL<T>& _pnl = FindPnL(_data.GetProduct());
+	realizedPnL += _data.GetRealizedPnL() - _pnl.GetRealizedPnL();
+	unrealizedPnL += _data.GetUnrealizedPnL() - _pnl.GetUnrealizedPnL();
+	_pnl = _data;
+}
+
+template<typename T>
+void PnLService<T>::AddListener(ServiceListener<PnL<T>>* _listener)
+{
+	listeners.push_back(_listener);
+}
+
+template<typename T>
+const vector<ServiceListener<PnL<T>>*>& PnLService<T>::GetListeners() const
+{
+	return listeners;
+}
+
+template<typename T>
+PnLToTradeBookingListener<T>* PnLService<T>::GetTradeListener()
+{
+	return tradeListener;
+}
+
+template<typename T>
+PnLToPricingListener<T>* PnLService<T>::GetPricingListener()
+{
+	return pricingListener;
+}
+
+template<typename T>
+PnL<T>& PnLService<T>::FindPnL(const T& _product)
+{
+	auto _iter = pnls.find(_product.GetProductId());
+	if (_iter == pnls.end())
+	{
+		_iter = pnls.insert(make_pair(_product.GetProductId(), PnL<T>(_product))).first;
+	}
+	return _iter->second;
+}
+
+template<typename T>
+void PnLService<T>::Publish(PnL<T>& _pnl)
+{
+	for (auto& l : listeners)
+	{
+		l->ProcessAdd(_pnl);
+	}
+}
+
+template<typename T>
+void PnLService<T>::AddTrade(const Trade<T>& _trade)
+{
+	PnL<T>& _pnl = FindPnL(_trade.GetProduct());
+	long _quantity = _trade.GetSide() == BUY ? _trade.GetQuantity() : -_trade.GetQuantity();
+	realizedPnL += _pnl.AddTrade(_trade.GetBook(), _quantity, _trade.GetPrice());
+
+	// The position moved, so the unrealized PnL is revalued at the last mark.
+	unrealizedPnL += _pnl.Revalue();
+	Publish(_pnl);
+}
+
+template<typename T>
+void PnLService<T>::AddPrice(const Price<T>& _price)
+{
+	PnL<T>& _pnl = FindPnL(_price.GetProduct());
+	unrealizedPnL += _pnl.Mark(_price.GetMid());
+	Publish(_pnl);
+}
+
+template<typename T>
+double PnLService<T>::GetRealizedPnL() const
+{
+	return realizedPnL;
+}
+
+template<typename T>
+double PnLService<T>::GetUnrealizedPnL() const
+{
+	return unrealizedPnL;
+}
+
+template<typename T>
+double PnLService<T>::GetTotalPnL() const
+{
+	return realizedPnL + unrealizedPnL;
+}
+
+/**
+* PnL Service Listener subscribing data from Trade Booking Service to PnL Service.
+* Type T is the product type.
+*/
+template<typename T>
+class PnLToTradeBookingListener : public ServiceListener<Trade<T>>
+{
+
+private:
+
+	PnLService<T>* service;
+
+public:
+
+	// Connector and Destructor
+	PnLToTradeBookingListener(PnLService<T>* _service);
+	~PnLToTradeBookingListener();
+
+	// Listener callback to process an add event to the Service
+	void ProcessAdd(Trade<T>& _data);
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(Trade<T>& _data);
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(Trade<T>& _data);
+
+};
+
+template<typename T>
+PnLToTradeBookingListener<T>::PnLToTradeBookingListener(PnLService<T>* _service)
+{
+	service = _service;
+}
+
+template<typename T>
+PnLToTradeBookingListener<T>::~PnLToTradeBookingListener() {}
+
+template<typename T>
+void PnLToTradeBookingListener<T>::ProcessAdd(Trade<T>& _data)
+{
+	service->AddTrade(_data);
+}
+
+template<typename T>
+void PnLToTradeBookingListener<T>::ProcessRemove(Trade<T>& _data) {}
+
+template<typename T>
+void PnLToTradeBookingListener<T>::ProcessUpdate(Trade<T>& _data) {}
+
+/**
+* PnL Service Listener subscribing data from Pricing Service to PnL Service.
+* Type T is the product type.
+*/
+template<typename T>
+class PnLToPricingListener : public ServiceListener<Price<T>>
+{
+
+private:
+
+	PnLService<T>* service;
+
+public:
+
+	// Connector and Destructor
+	PnLToPricingListener(PnLService<T>* _service);
+	~PnLToPricingListener();
+
+	// Listener callback to process an add event to the Service
+	void ProcessAdd(Price<T>& _data);
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(Price<T>& _data);
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(Price<T>& _data);
+
+};
+
+template<typename T>
+PnLToPricingListener<T>::PnLToPricingListener(PnLService<T>* _service)
+{
+	service = _service;
+}
+
+template<typename T>
+PnLToPricingListener<T>::~PnLToPricingListener() {}
+
+template<typename T>
+void PnLToPricingListener<T>::ProcessAdd(Price<T>& _data)
+{
+	service->AddPrice(_data);
+}
+
+template<typename T>
+void PnLToPricingListener<T>::ProcessRemove(Price<T>& _data) {}
+
+template<typename T>
+void PnLToPricingListener<T>::ProcessUpdate(Price<T>& _data) {}
+
+#endif
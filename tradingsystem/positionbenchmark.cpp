@@ -0,0 +1,71 @@
+/**
+* positionbenchmark.cpp
+* Times PositionService::AddTrade booking 10M trades across 1k products and 50 books.
+* Built on its own, and excluded from the trading system project, since it has
+* its own main:
+*     g++ -std=c++14 -O2 positionbenchmark.cpp -o positionbenchmark
+* Trades are drawn from a pool built up front, so the timing covers booking only.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include "positionservice.hpp"
+
+using namespace std;
+
+int main()
+{
+	const long _tradeCount = 10000000;
+	const long _productCount = 1000;
+	const long _bookCount = 50;
+	const long _poolSize = 1 << 16;
+
+	vector<Bond> _bonds;
+	for (long i = 0; i < _productCount; i++)
+	{
+		_bonds.push_back(Bond("BENCH" + to_string(i), CUSIP, "US" + to_string(i), 0.0, date(2030, Nov, 15)));
+	}
+	vector<string> _books;
+	for (long i = 0; i < _bookCount; i++)
+	{
+		_books.push_back("TRSY" + to_string(i + 1));
+	}
+
+	// A fixed linear congruential generator, so every run books the same trades.
+	unsigned long long _seed = 9815;
+	vector<Trade<Bond>> _trades;
+	long _expectedAggregate = 0;
+	for (long i = 0; i < _poolSize; i++)
+	{
+		_seed = _seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		const Bond& _bond = _bonds[(_seed >> 33) % _productCount];
+		const string& _book = _books[(_seed >> 17) % _bookCount];
+		long _quantity = 1000000 * (long)((_seed >> 45) % 10 + 1);
+		Side _side = (_seed >> 60) % 2 == 0 ? BUY : SELL;
+		_trades.push_back(Trade<Bond>(_bond, "T" + to_string(i), 100.0, _book, _quantity, _side));
+		_expectedAggregate += (_side == BUY ? _quantity : -_quantity) * (_tradeCount / _poolSize + (i < _tradeCount % _poolSize ? 1 : 0));
+	}
+
+	PositionService<Bond> _positionService;
+	auto _start = chrono::steady_clock::now();
+	for (long i = 0; i < _tradeCount; i++)
+	{
+		_positionService.AddTrade(_trades[i % _poolSize]);
+	}
+	auto _end = chrono::steady_clock::now();
+	double _nanoseconds = (double)chrono::duration_cast<chrono::nanoseconds>(_end - _start).count();
+
+	long _aggregate = 0;
+	for (auto& b : _bonds)
+	{
+		_aggregate += _positionService.GetData(b.GetProductId()).GetAggregatePosition();
+	}
+
+	cout << "Trades booked: " << _tradeCount << " across " << _productCount << " products and " << _bookCount << " books" << endl;
+	cout << "Nanoseconds per trade: " << _nanoseconds / _tradeCount << endl;
+	return _aggregate == _expectedAggregate ? 0 : 1;
+}
@@ -0,0 +1,612 @@
+/**
+* positionlimitservice.hpp
+* Defines the data types and Service for monitoring positions against product, book and desk limits.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef POSITION_LIMIT_SERVICE_HPP
+#define POSITION_LIMIT_SERVICE_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <limits>
+#include <cstdlib>
+#include <unordered_map>
+#include "soa.hpp"
+#include "positionservice.hpp"
+#include "snapshotpublisher.hpp"
+
+using namespace std;
+
+// Levels a position limit applies at
+enum LimitLevel { LIMIT_PRODUCT, LIMIT_BOOK, LIMIT_DESK };
+
+/**
+* Table of limits on absolute positions, by product with a default, by book and for the desk.
+* A book limit applies to the position of the book over all products, and the desk
+* limit to the position over all products and books.
+* A table is immutable once published to a position limit service.
+*/
+class PositionLimitTable
+{
+
+public:
+
+	// ctor for a position limit table, with no limit by default
+	PositionLimitTable();
+
+	// Set the limit of products without a limit of their own
+	void SetDefaultProductLimit(long _positionLimit);
+
+	// Set the limit of a product
+	void SetProductLimit(const string& _productId, long _positionLimit);
+
+	// Set the limit of a book
+	void SetBookLimit(const string& _book, long _positionLimit);
+
+	// Set the limit of the desk
+	void SetDeskLimit(long long _positionLimit);
+
+	// Get the limit of a product
+	long GetProductLimit(const string& _productId) const;
+
+	// Get the limit of a book
+	long GetBookLimit(const string& _book) const;
+
+	// Get the limit of the desk
+	long long GetDeskLimit() const;
+
+private:
+
+	long defaultProductLimit;
+	unordered_map<string, long> productLimits;
+	unordered_map<string, long> bookLimits;
+	long long deskLimit;
+
+};
+
+PositionLimitTable::PositionLimitTable()
+{
+	defaultProductLimit = numeric_limits<long>::max();
+	productLimits = unordered_map<string, long>();
+	bookLimits = unordered_map<string, long>();
+	deskLimit = numeric_limits<long long>::max();
+}
+
+void PositionLimitTable::SetDefaultProductLimit(long _positionLimit)
+{
+	defaultProductLimit = _positionLimit;
+}
+
+void PositionLimitTable::SetProductLimit(const string& _productId, long _positionLimit)
+{
+	productLimits[_productId] = _positionLimit;
+}
+
+void PositionLimitTable::SetBookLimit(const string& _book, long _positionLimit)
+{
+	bookLimits[_book] = _positionLimit;
+}
+
+void PositionLimitTable::SetDeskLimit(long long _positionLimit)
+{
+	deskLimit = _positionLimit;
+}
+
+long PositionLimitTable::GetProductLimit(const string& _productId) const
+{
+	auto _iter = productLimits.find(_productId);
+	return _iter != productLimits.end() ? _iter->second : defaultProductLimit;
+}
+
+long PositionLimitTable::GetBookLimit(const string& _book) const
+{
+	auto _iter = bookLimits.find(_book);
+	return _iter != bookLimits.end() ? _iter->second : numeric_limits<long>::max();
+}
+
+long long PositionLimitTable::GetDeskLimit() const
+{
+	return deskLimit;
+}
+
+/**
+* Limit breach raised by the position limit monitor.
+* Type T is the product type.
+*/
+template<typename T>
+class LimitBreach
+{
+
+public:
+
+	// ctor for a limit breach
+	LimitBreach();
+	LimitBreach(const T& _product, LimitLevel _level, const string& _name, long long _position, long long _positionLimit);
+
+	// Get the product whose position update raised the breach
+	const T& GetProduct() const;
+
+	// Get the level of the breached limit
+	LimitLevel GetLevel() const;
+
+	// Get the name of the breached product, book or desk
+	const string& GetName() const;
+
+	// Get the position at the breach
+	long long GetPosition() const;
+
+	// Get the breached limit
+	long long GetPositionLimit() const;
+
+	// Get the key of the breach, one for each limit
+	string GetKey() const;
+
+	// Change attributes to strings
+	vector<string> ToStrings() const;
+
+private:
+
+	T product;
+	LimitLevel level;
+	string name;
+	long long position;
+	long long positionLimit;
+
+};
+
+template<typename T>
+LimitBreach<T>::LimitBreach()
+{
+	level = LIMIT_PRODUCT;
+	position = 0;
+	positionLimit = 0;
+}
+
+template<typename T>
+LimitBreach<T>::LimitBreach(const T& _product, LimitLevel _level, const string& _name, long long _position, long long _positionLimit) :
+	product(_product), level(_level), name(_name), position(_position), positionLimit(_positionLimit) {}
+
+template<typename T>
+const T& LimitBreach<T>::GetProduct() const
+{
+	return product;
+}
+
+template<typename T>
+LimitLevel LimitBreach<T>::GetLevel() const
+{
+	return level;
+}
+
+template<typename T>
+const string& LimitBreach<T>::GetName() const
+{
+	return name;
+}
+
+template<typename T>
+long long LimitBreach<T>::GetPosition() const
+{
+	return position;
+}
+
+template<typename T>
+long long LimitBreach<T>::GetPositionLimit() const
+{
+	return positionLimit;
+}
+
+template<typename T>
+string LimitBreach<T>::GetKey() const
+{
+	switch (level)
+	{
+	case LIMIT_PRODUCT:
+		return "PRODUCT:" + name;
+	case LIMIT_BOOK:
+		return "BOOK:" + name;
+	default:
+		return "DESK";
+	}
+}
+
+template<typename T>
+vector<string> LimitBreach<T>::ToStrings() const
+{
+	string _level;
+	switch (level)
+	{
+	case LIMIT_PRODUCT:
+		_level = "PRODUCT";
+		break;
+	case LIMIT_BOOK:
+		_level = "BOOK";
+		break;
+	case LIMIT_DESK:
+		_level = "DESK";
+		break;
+	}
+
+	vector<string> _strings;
+	_strings.push_back(product.GetProductId());
+	_strings.push_back(_level);
+	_strings.push_back(name);
+	_strings.push_back(to_string(position));
+	_strings.push_back(to_string(positionLimit));
+	return _strings;
+}
+
+/**
+* Pre-declearations to avoid errors.
+*/
+template<typename T>
+class PositionLimitToPositionListener;
+
+/**
+* Position limit service monitoring every position update against the limits of
+* its product, of the books it touches and of the desk.
+* A limit going into breach is published to the listeners as an add event, and
+* coming back within its limit as a remove event, so a position sitting in breach
+* raises it once.
+* Book and desk positions are kept up to date from the change in each position,
+* so a check never sums over products. The limit table is read through a snapshot
+* publisher, so checks never lock while a new table is published from another
+* thread, and a replaced table is freed once no check is still reading it. The
+* limits of each product and book are looked up once per table version and cached,
+* so the usual check is a handful of integer compares. A new
+* table is taken up at the next position update, when every book and the desk are
+* checked against it, while products are checked as they are next updated.
+* Keyed on breach key.
+* Type T is the product type.
+*/
+template<typename T>
+class PositionLimitService : public Service<string, LimitBreach<T>>
+{
+
+private:
+
+	struct BookState
+	{
+		string book;
+		long bookId;
+		long position;
+	};
+
+	struct ProductState
+	{
+		long long aggregatePosition;
+		vector<BookState> books;
+		long long limitVersion;
+		long positionLimit;
+		bool breached;
+	};
+
+	map<string, LimitBreach<T>> breaches;
+	vector<ServiceListener<LimitBreach<T>>*> listeners;
+	PositionLimitToPositionListener<T>* listener;
+	unordered_map<string, ProductState> products;
+	BookRegistry bookRegistry;
+	vector<long long> bookPositions;
+	vector<long> bookLimits;
+	vector<bool> bookBreached;
+	long long deskPosition;
+	long long deskLimit;
+	bool deskBreached;
+	long long currentVersion;
+	SnapshotPublisher<PositionLimitTable> limitTables;
+
+	// Take up a newly published limit table of a version, and check every book and the desk against it
+	void Refresh(const T& _product, const PositionLimitTable* _limitTable, long long _version);
+
+	// Get the index of a book, adding it if it is new
+	long AddBook(const string& _book, const PositionLimitTable* _limitTable);
+
+	// Raise or clear a breach as a position moves across its limit
+	void Check(const T& _product, LimitLevel _level, const string& _name, long long _position, long long _positionLimit, bool& _breached);
+
+public:
+
+	// Constructor and destructor
+	PositionLimitService();
+	~PositionLimitService();
+
+	// Get data on our service given a key
+	LimitBreach<T>& GetData(string _key);
+
+	// The callback that a Connector should invoke for any new or updated data
+	void OnMessage(LimitBreach<T>& _data);
+
+	// Add a listener to the Service for callbacks on add, remove, and update events for data to the Service
+	void AddListener(ServiceListener<LimitBreach<T>>* _listener);
+
+	// Get all listeners on the Service
+	const vector<ServiceListener<LimitBreach<T>>*>& GetListeners() const;
+
+	// Get the listener of the service
+	PositionLimitToPositionListener<T>* GetListener();
+
+	// Publish a new limit table
+	void SetLimitTable(const PositionLimitTable& _limitTable);
+
+	// Get a copy of the current limit table
+	PositionLimitTable GetLimitTable() const;
+
+	// Check an updated position against the limits
+	void UpdatePosition(Position<T>& _position);
+
+	// Get the position of a book over all products
+	long long GetBookPosition(const string& _book) const;
+
+	// Get the position of the desk
+	long long GetDeskPosition() const;
+
+	// Get the breaches currently open
+	const map<string, LimitBreach<T>>& GetBreaches() const;
+
+};
+
+template<typename T>
+PositionLimitService<T>::PositionLimitService() :
+	limitTables(PositionLimitTable())
+{
+	breaches = map<string, LimitBreach<T>>();
+	listeners = vector<ServiceListener<LimitBreach<T>>*>();
+	listener = new PositionLimitToPositionListener<T>(this);
+	products = unordered_map<string, ProductState>();
+	bookRegistry = BookRegistry();
+	bookPositions = vector<long long>();
+	bookLimits = vector<long>();
+	bookBreached = vector<bool>();
+	deskPosition = 0;
+	deskLimit = numeric_limits<long long>::max();
+	deskBreached = false;
+	currentVersion = 0;
+}
+
+template<typename T>
+PositionLimitService<T>::~PositionLimitService() {}
+
+template<typename T>
+LimitBreach<T>& PositionLimitService<T>::GetData(string _key)
+{
+	return breaches[_key];
+}
+
+template<typename T>
+void PositionLimitService<T>::OnMessage(LimitBreach<T>& _data)
+{
+	breaches[_data.GetKey()] = _data;
+}
+
+template<typename T>
+void PositionLimitService<T>::AddListener(ServiceListener<LimitBreach<T>>* _listener)
+{
+	listeners.push_back(_listener);
+}
+
+template<typename T>
+const vector<ServiceListener<LimitBreach<T>>*>& PositionLimitService<T>::GetListeners() const
+{
+	return listeners;
+}
+
+template<typename T>
+PositionLimitToPositionListener<T>* PositionLimitService<T>::GetListener()
+{
+	return listener;
+}
+
+template<typename T>
+void PositionLimitService<T>::SetLimitTable(const PositionLimitTable& _limitTable)
+{
+	limitTables.Publish(_limitTable);
+}
+
+template<typename T>
+PositionLimitTable PositionLimitService<T>::GetLimitTable() const
+{
+	SnapshotReader<PositionLimitTable> _reader(limitTables);
+	return _reader.Get();
+}
+
+template<typename T>
+long PositionLimitService<T>::AddBook(const string& _book, const PositionLimitTable* _limitTable)
+{
+	long _bookId = bookRegistry.FindBook(_book);
+	if (_bookId >= 0) return _bookId;
+	_bookId = bookRegistry.AddBook(_book);
+	bookPositions.push_back(0);
+	bookLimits.push_back(_limitTable->GetBookLimit(_book));
+	bookBreached.push_back(false);
+	return _bookId;
+}
+
+template<typename T>
+void PositionLimitService<T>::Check(const T& _product, LimitLevel _level, const string& _name, long long _position, long long _positionLimit, bool& _breached)
+{
+	bool _breaching = llabs(_position) > _positionLimit;
+	if (_breaching == _breached) return;
+	_breached = _breaching;
+
+	LimitBreach<T> _breach(_product, _level, _name, _position, _positionLimit);
+	if (_breaching)
+	{
+		OnMessage(_breach);
+		for (auto& l : listeners)
+		{
+			l->ProcessAdd(_breach);
+		}
+	}
+	else
+	{
+		breaches.erase(_breach.GetKey());
+		for (auto& l : listeners)
+		{
+			l->ProcessRemove(_breach);
+		}
+	}
+}
+
+template<typename T>
+void PositionLimitService<T>::Refresh(const T& _product, const PositionLimitTable* _limitTable, long long _version)
+{
+	currentVersion = _version;
+	deskLimit = _limitTable->GetDeskLimit();
+	for (long i = 0; i < (long)bookLimits.size(); i++)
+	{
+		bookLimits[i] = _limitTable->GetBookLimit(bookRegistry.GetBookName(i));
+		bool _breached = bookBreached[i];
+		Check(_product, LIMIT_BOOK, bookRegistry.GetBookName(i), bookPositions[i], bookLimits[i], _breached);
+		bookBreached[i] = _breached;
+	}
+	Check(_product, LIMIT_DESK, "DESK", deskPosition, deskLimit, deskBreached);
+}
+
+template<typename T>
+void PositionLimitService<T>::UpdatePosition(Position<T>& _position)
+{
+	const T& _product = _position.GetProduct();
+	SnapshotReader<PositionLimitTable> _reader(limitTables);
+	const PositionLimitTable* _limitTable = &_reader.Get();
+	long long _version = _reader.GetVersion();
+	if (_version != currentVersion) Refresh(_product, _limitTable, _version);
+
+	const string& _productId = _product.GetProductId();
+	auto _iter = products.find(_productId);
+	if (_iter == products.end())
+	{
+		ProductState _state;
+		_state.aggregatePosition = 0;
+		_state.limitVersion = 0;
+		_state.positionLimit = numeric_limits<long>::max();
+		_state.breached = false;
+		_iter = products.insert(make_pair(_productId, _state)).first;
+	}
+	ProductState& _state = _iter->second;
+	if (_state.limitVersion != _version)
+	{
+		_state.limitVersion = _version;
+		_state.positionLimit = _limitTable->GetProductLimit(_productId);
+	}
+
+	// Books of the position and of the cached state are both in name order, so they are
+	// walked together, and only books whose position moved are checked.
+	const map<string, long>& _positions = _position.GetPositions();
+	vector<BookState>& _books = _state.books;
+	auto _positionIter = _positions.begin();
+	size_t i = 0;
+	while (_positionIter != _positions.end() || i < _books.size())
+	{
+		long _bookId;
+		long _change;
+		if (i < _books.size() && (_positionIter == _positions.end() || _books[i].book < _positionIter->first))
+		{
+			// A book gone from the position is flat.
+			_bookId = _books[i].bookId;
+			_change = -_books[i].position;
+			_books.erase(_books.begin() + i);
+		}
+		else
+		{
+			if (i == _books.size() || _positionIter->first < _books[i].book)
+			{
+				BookState _book;
+				_book.book = _positionIter->first;
+				_book.bookId = AddBook(_book.book, _limitTable);
+				_book.position = 0;
+				_books.insert(_books.begin() + i, _book);
+			}
+			_bookId = _books[i].bookId;
+			_change = _positionIter->second - _books[i].position;
+			_books[i].position = _positionIter->second;
+			++_positionIter;
+			++i;
+		}
+		if (_change == 0) continue;
+
+		bookPositions[_bookId] += _change;
+		bool _breached = bookBreached[_bookId];
+		Check(_product, LIMIT_BOOK, bookRegistry.GetBookName(_bookId), bookPositions[_bookId], bookLimits[_bookId], _breached);
+		bookBreached[_bookId] = _breached;
+	}
+
+	long long _aggregatePosition = _position.GetAggregatePosition();
+	deskPosition += _aggregatePosition - _state.aggregatePosition;
+	_state.aggregatePosition = _aggregatePosition;
+	Check(_product, LIMIT_PRODUCT, _productId, _aggregatePosition, _state.positionLimit, _state.breached);
+	Check(_product, LIMIT_DESK, "DESK", deskPosition, deskLimit, deskBreached);
+}
+
+template<typename T>
+long long PositionLimitService<T>::GetBookPosition(const string& _book) const
+{
+	long _bookId = bookRegistry.FindBook(_book);
+	return _bookId >= 0 ? bookPositions[_bookId] : 0;
+}
+
+template<typename T>
+long long PositionLimitService<T>::GetDeskPosition() const
+{
+	return deskPosition;
+}
+
+template<typename T>
+const map<string, LimitBreach<T>>& PositionLimitService<T>::GetBreaches() const
+{
+	return breaches;
+}
+
+/**
+* Position Limit Service Listener subscribing data from Position Service to Position Limit Service.
+* Type T is the product type.
+*/
+template<typename T>
+class PositionLimitToPositionListener : public ServiceListener<Position<T>>
+{
+
+private:
+
+	PositionLimitService<T>* service;
+
+public:
+
+	// Connector and Destructor
+	PositionLimitToPositionListener(PositionLimitService<T>* _service);
+	~PositionLimitToPositionListener();
+
+	// Listener callback to process an add event to the Service
+	void ProcessAdd(Position<T>& _data);
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(Position<T>& _data);
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(Position<T>& _data);
+
+};
+
+template<typename T>
+PositionLimitToPositionListener<T>::PositionLimitToPositionListener(PositionLimitService<T>* _service)
+{
+	service = _service;
+}
+
+template<typename T>
+PositionLimitToPositionListener<T>::~PositionLimitToPositionListener() {}
+
+template<typename T>
+void PositionLimitToPositionListener<T>::ProcessAdd(Position<T>& _data)
+{
+	service->UpdatePosition(_data);
+}
+
+template<typename T>
+void PositionLimitToPositionListener<T>::ProcessRemove(Position<T>& _data) {}
+
+template<typename T>
+void PositionLimitToPositionListener<T>::ProcessUpdate(Position<T>& _data) {}
+
+#endif
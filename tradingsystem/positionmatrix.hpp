@@ -0,0 +1,314 @@
+/**
+* positionmatrix.hpp
+* Defines the book registry and the dense product by book position matrix.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef POSITION_MATRIX_HPP
+#define POSITION_MATRIX_HPP
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#if defined(__AVX2__) || defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+/**
+* Registry interning book names into dense indexes.
+* A book keeps the index it was first given, so indexes can address columns.
+*/
+class BookRegistry
+{
+
+public:
+
+	// ctor for an empty registry
+	BookRegistry();
+
+	// Get the index of a book, adding the book if it is new
+	long AddBook(const string& _book);
+
+	// Get the index of a book, or -1 if it is unknown
+	long FindBook(const string& _book) const;
+
+	// Get the name of a book
+	const string& GetBookName(long _bookId) const;
+
+	// Get the number of books
+	long GetBookCount() const;
+
+private:
+
+	unordered_map<string, long> bookIds;
+	vector<string> bookNames;
+
+};
+
+BookRegistry::BookRegistry()
+{
+	bookIds = unordered_map<string, long>();
+	bookNames = vector<string>();
+}
+
+long BookRegistry::AddBook(const string& _book)
+{
+	auto _iter = bookIds.find(_book);
+	if (_iter != bookIds.end()) return _iter->second;
+	long _bookId = bookNames.size();
+	bookIds.insert(make_pair(_book, _bookId));
+	bookNames.push_back(_book);
+	return _bookId;
+}
+
+long BookRegistry::FindBook(const string& _book) const
+{
+	auto _iter = bookIds.find(_book);
+	return _iter == bookIds.end() ? -1 : _iter->second;
+}
+
+const string& BookRegistry::GetBookName(long _bookId) const
+{
+	return bookNames[_bookId];
+}
+
+long BookRegistry::GetBookCount() const
+{
+	return bookNames.size();
+}
+
+// Add a run of cells into the column totals and get the sum of the run. The count is a multiple of 4.
+inline long long AccumulateCells(const long long* _cells, long long* _totals, long _count)
+{
+#if defined(__AVX2__)
+	__m256i _sum = _mm256_setzero_si256();
+	for (long i = 0; i < _count; i += 4)
+	{
+		__m256i _value = _mm256_loadu_si256((const __m256i*)(_cells + i));
+		_sum = _mm256_add_epi64(_sum, _value);
+		_mm256_storeu_si256((__m256i*)(_totals + i), _mm256_add_epi64(_mm256_loadu_si256((const __m256i*)(_totals + i)), _value));
+	}
+	__m128i _half = _mm_add_epi64(_mm256_castsi256_si128(_sum), _mm256_extracti128_si256(_sum, 1));
+	return _mm_cvtsi128_si64(_half) + _mm_cvtsi128_si64(_mm_unpackhi_epi64(_half, _half));
+#elif defined(__x86_64__) || defined(_M_X64)
+	__m128i _sum = _mm_setzero_si128();
+	for (long i = 0; i < _count; i += 2)
+	{
+		__m128i _value = _mm_loadu_si128((const __m128i*)(_cells + i));
+		_sum = _mm_add_epi64(_sum, _value);
+		_mm_storeu_si128((__m128i*)(_totals + i), _mm_add_epi64(_mm_loadu_si128((const __m128i*)(_totals + i)), _value));
+	}
+	return _mm_cvtsi128_si64(_sum) + _mm_cvtsi128_si64(_mm_unpackhi_epi64(_sum, _sum));
+#else
+	long long _sum = 0;
+	for (long i = 0; i < _count; i++)
+	{
+		_sum += _cells[i];
+		_totals[i] += _cells[i];
+	}
+	return _sum;
+#endif
+}
+
+// Get the sum of a run of cells. The count is a multiple of 4.
+inline long long SumCells(const long long* _cells, long _count)
+{
+#if defined(__AVX2__)
+	__m256i _sum = _mm256_setzero_si256();
+	for (long i = 0; i < _count; i += 4)
+	{
+		_sum = _mm256_add_epi64(_sum, _mm256_loadu_si256((const __m256i*)(_cells + i)));
+	}
+	__m128i _half = _mm_add_epi64(_mm256_castsi256_si128(_sum), _mm256_extracti128_si256(_sum, 1));
+	return _mm_cvtsi128_si64(_half) + _mm_cvtsi128_si64(_mm_unpackhi_epi64(_half, _half));
+#elif defined(__x86_64__) || defined(_M_X64)
+	__m128i _sum = _mm_setzero_si128();
+	for (long i = 0; i < _count; i += 2)
+	{
+		_sum = _mm_add_epi64(_sum, _mm_loadu_si128((const __m128i*)(_cells + i)));
+	}
+	return _mm_cvtsi128_si64(_sum) + _mm_cvtsi128_si64(_mm_unpackhi_epi64(_sum, _sum));
+#else
+	long long _sum = 0;
+	for (long i = 0; i < _count; i++) _sum += _cells[i];
+	return _sum;
+#endif
+}
+
+/**
+* Dense matrix of positions with a row per product and a column per book.
+* Rows are laid out one after another with a stride padded to a multiple of 4
+* cells, so a row is a run of whole vector registers and reductions never need a
+* scalar tail. Padding cells stay zero. When a book falls beyond the stride the
+* stride doubles and the rows are laid out again, which only happens as books are
+* first seen. Product, book and desk totals come out of one pass over the cells.
+*/
+class PositionMatrix
+{
+
+public:
+
+	// ctor for an empty matrix
+	PositionMatrix();
+
+	// Get the row of a product, adding the product if it is new
+	long AddProduct(const string& _productId);
+
+	// Get the row of a product, or -1 if it is unknown
+	long FindProduct(const string& _productId) const;
+
+	// Get the product of a row
+	const string& GetProductId(long _productRow) const;
+
+	// Get the number of products
+	long GetProductCount() const;
+
+	// Get the registry of the books
+	const BookRegistry& GetBookRegistry() const;
+
+	// Add a position to a product in a book
+	void AddPosition(const string& _productId, const string& _book, long long _position);
+	void AddPosition(long _productRow, long _bookId, long long _position);
+
+	// Get the position of a product in a book
+	long long GetPosition(long _productRow, long _bookId) const;
+
+	// Get the position of a product over all books
+	long long GetProductPosition(long _productRow) const;
+
+	// Get the position of a book over all products
+	long long GetBookPosition(long _bookId) const;
+
+	// Get the position over all products and books
+	long long GetDeskPosition() const;
+
+	// Get the totals of every product and every book, and the desk total, in one pass
+	long long Aggregate(vector<long long>& _productPositions, vector<long long>& _bookPositions) const;
+
+private:
+
+	BookRegistry books;
+	unordered_map<string, long> productRows;
+	vector<string> productIds;
+	vector<long long> cells;
+	long stride;
+
+	// Widen the rows to hold a book
+	void Reserve(long _bookId);
+
+};
+
+PositionMatrix::PositionMatrix()
+{
+	productRows = unordered_map<string, long>();
+	productIds = vector<string>();
+	cells = vector<long long>();
+	stride = 4;
+}
+
+long PositionMatrix::AddProduct(const string& _productId)
+{
+	auto _iter = productRows.find(_productId);
+	if (_iter != productRows.end()) return _iter->second;
+	long _productRow = productIds.size();
+	productRows.insert(make_pair(_productId, _productRow));
+	productIds.push_back(_productId);
+	cells.resize(cells.size() + stride, 0);
+	return _productRow;
+}
+
+long PositionMatrix::FindProduct(const string& _productId) const
+{
+	auto _iter = productRows.find(_productId);
+	return _iter == productRows.end() ? -1 : _iter->second;
+}
+
+const string& PositionMatrix::GetProductId(long _productRow) const
+{
+	return productIds[_productRow];
+}
+
+long PositionMatrix::GetProductCount() const
+{
+	return productIds.size();
+}
+
+const BookRegistry& PositionMatrix::GetBookRegistry() const
+{
+	return books;
+}
+
+void PositionMatrix::Reserve(long _bookId)
+{
+	if (_bookId < stride) return;
+	long _stride = stride;
+	while (_bookId >= _stride) _stride *= 2;
+	vector<long long> _cells(productIds.size() * _stride, 0);
+	for (long r = 0; r < (long)productIds.size(); r++)
+	{
+		copy(cells.begin() + r * stride, cells.begin() + (r + 1) * stride, _cells.begin() + r * _stride);
+	}
+	cells.swap(_cells);
+	stride = _stride;
+}
+
+void PositionMatrix::AddPosition(const string& _productId, const string& _book, long long _position)
+{
+	long _productRow = AddProduct(_productId);
+	long _bookId = books.AddBook(_book);
+	AddPosition(_productRow, _bookId, _position);
+}
+
+void PositionMatrix::AddPosition(long _productRow, long _bookId, long long _position)
+{
+	Reserve(_bookId);
+	cells[_productRow * stride + _bookId] += _position;
+}
+
+long long PositionMatrix::GetPosition(long _productRow, long _bookId) const
+{
+	if (_bookId >= stride) return 0;
+	return cells[_productRow * stride + _bookId];
+}
+
+long long PositionMatrix::GetProductPosition(long _productRow) const
+{
+	return SumCells(cells.data() + _productRow * stride, stride);
+}
+
+long long PositionMatrix::GetBookPosition(long _bookId) const
+{
+	if (_bookId >= stride) return 0;
+	long long _position = 0;
+	for (size_t i = _bookId; i < cells.size(); i += stride)
+	{
+		_position += cells[i];
+	}
+	return _position;
+}
+
+long long PositionMatrix::GetDeskPosition() const
+{
+	return SumCells(cells.data(), cells.size());
+}
+
+long long PositionMatrix::Aggregate(vector<long long>& _productPositions, vector<long long>& _bookPositions) const
+{
+	long _productCount = productIds.size();
+	_productPositions.assign(_productCount, 0);
+	vector<long long> _columns(stride, 0);
+	long long _deskPosition = 0;
+	for (long r = 0; r < _productCount; r++)
+	{
+		_productPositions[r] = AccumulateCells(cells.data() + r * stride, _columns.data(), stride);
+		_deskPosition += _productPositions[r];
+	}
+	_bookPositions.assign(_columns.begin(), _columns.begin() + books.GetBookCount());
+	return _deskPosition;
+}
+
+#endif
@@ -10,13 +10,17 @@
 
 #include <string>
 #include <map>
+#include <unordered_map>
 #include "soa.hpp"
 #include "tradebookingservice.hpp"
+#include "positionmatrix.hpp"
 
 using namespace std;
 
 /**
 * Position class in a particular book.
+* The aggregate over books is kept as positions are added, so reading it does
+* not walk the books.
 * Type T is the product type.
 */
 template<typename T>
@@ -26,23 +30,23 @@ class Position
 public:
 
 	// ctor for a position
-	Position() = default;
+	Position();
 	Position(const T& _product);
 
 	// Get the product
 	const T& GetProduct() const;
 
 	// Get the position quantity
-	long GetPosition(string& _book);
+	long GetPosition(const string& _book) const;
 
 	// Get the positions over books
-	map<string, long> GetPositions();
+	const map<string, long>& GetPositions() const;
 
 	// Set the position quantity
-	void AddPosition(string& _book, long _position);
+	void AddPosition(const string& _book, long _position);
 
 	// Get the aggregate position
-	long GetAggregatePosition();
+	long GetAggregatePosition() const;
 
 	// Change attributes to strings
 	vector<string> ToStrings() const;
@@ -51,12 +55,17 @@ private:
 
 	T product;
 	map<string, long> positions;
+	long aggregatePosition;
 
 };
 
+template<typename T>
+Position<T>::Position() :
+	aggregatePosition(0) {}
+
 template<typename T>
 Position<T>::Position(const T& _product) :
-	product(_product) {}
+	product(_product), aggregatePosition(0) {}
 
 template<typename T>
 const T& Position<T>::GetProduct() const
@@ -65,31 +74,28 @@ const T& Position<T>::GetProduct() const
 }
 
 template<typename T>
-long Position<T>::GetPosition(string& _book)
+long Position<T>::GetPosition(const string& _book) const
 {
-	return positions[_book];
+	auto _iter = positions.find(_book);
+	return _iter == positions.end() ? 0 : _iter->second;
 }
 
 template<typename T>
-map<string, long> Position<T>::GetPositions()
+const map<string, long>& Position<T>::GetPositions() const
 {
 	return positions;
 }
 
 template<typename T>
-void Position<T>::AddPosition(string& _book, long _position)
+void Position<T>::AddPosition(const string& _book, long _position)
 {
 	positions[_book] += _position;
+	aggregatePosition += _position;
 }
 
 template<typename T>
-long Position<T>::GetAggregatePosition()
+long Position<T>::GetAggregatePosition() const
 {
-	long aggregatePosition = 0;
-	for (auto& p : positions)
-	{
-		aggregatePosition += p.second;
-	}
 	return aggregatePosition;
 }
 
@@ -120,6 +126,14 @@ class PositionToTradeBookingListener;
 
 /**
 * Position Service to manage positions across multiple books and secruties.
+* Besides the position of each product, every trade lands in a dense product by
+* book matrix that product, book and desk totals are read from.
+* Positions are published on every change, unless changes are coalesced within a
+* batch or a time window. Then a changed product is only published once, with its
+* net position, when the batch ends or the window runs out, and the changes it
+* held back are counted for each product.
+* A window is only checked on a change or on a timer, so with a window set the
+* caller drives OnTimer, or the last changes wait for the next trade to publish.
 * Keyed on product identifier.
 * Type T is the product type.
 */
@@ -132,6 +146,21 @@ private:
 	map<string, Position<T>> positions;
 	vector<ServiceListener<Position<T>>*> listeners;
 	PositionToTradeBookingListener<T>* listener;
+	PositionMatrix positionMatrix;
+	struct CoalescingState
+	{
+		bool pending;
+		long suppressedCount;
+	};
+
+	unordered_map<string, CoalescingState> coalescingStates;
+	vector<pair<Position<T>*, CoalescingState*>> pendingPositions;
+	long batchDepth;
+	long long coalescingWindow;
+	long long windowStart;
+
+	// Publish a changed position, or hold it back while changes are coalesced
+	void Publish(Position<T>& _position);
 
 public:
 
@@ -157,6 +186,36 @@ public:
 	// Add a trade to the service
 	virtual void AddTrade(const Trade<T>& _trade);
 
+	// Add positions in many books to a product at once, publishing it once
+	void AddPositions(const T& _product, const map<string, long>& _positions);
+
+	// Replace the position of a product with a restored one, and publish it
+	void RestorePosition(Position<T>& _data);
+
+	// Get the positions of all products over all books
+	const PositionMatrix& GetPositionMatrix() const;
+
+	// Get the positions of all products
+	const map<string, Position<T>>& GetPositions() const;
+
+	// Start a batch of changes published together when it ends
+	void BeginBatch();
+
+	// End a batch of changes, publishing them when no outer batch is open
+	void EndBatch();
+
+	// Set the time window in microseconds changes are coalesced over, or 0 to publish each change
+	void SetCoalescingWindow(long long _coalescingWindow);
+
+	// Publish every position held back
+	void Flush();
+
+	// Publish the positions held back when the window has run out by a time in microseconds
+	void OnTimer(long long _time);
+
+	// Get the number of changes of a product held back and netted into a later publication
+	long GetSuppressedCount(const string& _productId) const;
+
 };
 
 template<typename T>
@@ -165,6 +224,12 @@ PositionService<T>::PositionService()
 	positions = map<string, Position<T>>();
 	listeners = vector<ServiceListener<Position<T>>*>();
 	listener = new PositionToTradeBookingListener<T>(this);
+	positionMatrix = PositionMatrix();
+	coalescingStates = unordered_map<string, CoalescingState>();
+	pendingPositions = vector<pair<Position<T>*, CoalescingState*>>();
+	batchDepth = 0;
+	coalescingWindow = 0;
+	windowStart = 0;
 }
 
 template<typename T>
@@ -179,7 +244,17 @@ Position<T>& PositionService<T>::GetData(string _key)
 template<typename T>
 void PositionService<T>::OnMessage(Position<T>& _data)
 {
-	positions[_data.GetProduct().GetProductId()] = _data;
+	const string& _productId = _data.GetProduct().GetProductId();
+	Position<T>& _position = positions[_productId];
+	for (auto& p : _position.GetPositions())
+	{
+		positionMatrix.AddPosition(_productId, p.first, -p.second);
+	}
+	for (auto& p : _data.GetPositions())
+	{
+		positionMatrix.AddPosition(_productId, p.first, p.second);
+	}
+	_position = _data;
 }
 
 template<typename T>
@@ -203,37 +278,135 @@ const vector<ServiceListener<Position<T>>*>& PositionService<T>::GetListeners()
 template<typename T>
 void PositionService<T>::AddTrade(const Trade<T>& _trade)
 {
-	T _product = _trade.GetProduct();
-	string _productId = _product.GetProductId();
-	double _price = _trade.GetPrice();
-	string _book = _trade.GetBook();
+	const T& _product = _trade.GetProduct();
+	const string& _productId = _product.GetProductId();
+	auto _iter = positions.find(_productId);
+	if (_iter == positions.end())
+	{
+		_iter = positions.insert(make_pair(_productId, Position<T>(_product))).first;
+	}
+
+	// Positions are updated where they live, a buy adding to the book and a sell taking from it.
+	Position<T>& _position = _iter->second;
 	long _quantity = _trade.GetQuantity();
-	Side _side = _trade.GetSide();
-	Position<T> _positionTo(_product);
-	switch (_side)
+	if (_trade.GetSide() == SELL) _quantity = -_quantity;
+	_position.AddPosition(_trade.GetBook(), _quantity);
+	positionMatrix.AddPosition(_productId, _trade.GetBook(), _quantity);
+	Publish(_position);
+}
+
+template<typename T>
+void PositionService<T>::AddPositions(const T& _product, const map<string, long>& _positions)
+{
+	const string& _productId = _product.GetProductId();
+	auto _iter = positions.find(_productId);
+	if (_iter == positions.end())
 	{
-	case BUY:
-		_positionTo.AddPosition(_book, _quantity);
-		break;
-	case SELL:
-		_positionTo.AddPosition(_book, -_quantity);
-		break;
+		_iter = positions.insert(make_pair(_productId, Position<T>(_product))).first;
 	}
 
-	Position<T> _positionFrom = positions[_productId];
-	map <string, long> _positionMap = _positionFrom.GetPositions();
-	for (auto& p : _positionMap)
+	Position<T>& _position = _iter->second;
+	for (auto& p : _positions)
+	{
+		_position.AddPosition(p.first, p.second);
+		positionMatrix.AddPosition(_productId, p.first, p.second);
+	}
+	Publish(_position);
+}
+
+template<typename T>
+void PositionService<T>::RestorePosition(Position<T>& _data)
+{
+	OnMessage(_data);
+	Publish(positions[_data.GetProduct().GetProductId()]);
+}
+
+template<typename T>
+void PositionService<T>::Publish(Position<T>& _position)
+{
+	if (batchDepth == 0 && coalescingWindow == 0)
 	{
-		_book = p.first;
-		_quantity = p.second;
-		_positionTo.AddPosition(_book, _quantity);
+		for (auto& l : listeners)
+		{
+			l->ProcessAdd(_position);
+		}
+		return;
 	}
-	positions[_productId] = _positionTo;
 
-	for (auto& l : listeners)
+	// A product already waiting to be published only has its change counted.
+	CoalescingState& _state = coalescingStates[_position.GetProduct().GetProductId()];
+	if (_state.pending)
 	{
-		l->ProcessAdd(_positionTo);
+		_state.suppressedCount++;
 	}
+	else
+	{
+		_state.pending = true;
+		pendingPositions.push_back(make_pair(&_position, &_state));
+	}
+
+	if (batchDepth == 0 && GetEpochMicrosecond() - windowStart >= coalescingWindow) Flush();
+}
+
+template<typename T>
+void PositionService<T>::BeginBatch()
+{
+	batchDepth++;
+}
+
+template<typename T>
+void PositionService<T>::EndBatch()
+{
+	if (batchDepth > 0 && --batchDepth == 0) Flush();
+}
+
+template<typename T>
+void PositionService<T>::SetCoalescingWindow(long long _coalescingWindow)
+{
+	coalescingWindow = _coalescingWindow;
+	windowStart = GetEpochMicrosecond();
+	if (coalescingWindow == 0 && batchDepth == 0) Flush();
+}
+
+template<typename T>
+void PositionService<T>::Flush()
+{
+	vector<pair<Position<T>*, CoalescingState*>> _positions;
+	_positions.swap(pendingPositions);
+	for (auto& p : _positions)
+	{
+		p.second->pending = false;
+		for (auto& l : listeners)
+		{
+			l->ProcessAdd(*p.first);
+		}
+	}
+	windowStart = GetEpochMicrosecond();
+}
+
+template<typename T>
+void PositionService<T>::OnTimer(long long _time)
+{
+	if (batchDepth == 0 && coalescingWindow > 0 && !pendingPositions.empty() && _time - windowStart >= coalescingWindow) Flush();
+}
+
+template<typename T>
+long PositionService<T>::GetSuppressedCount(const string& _productId) const
+{
+	auto _iter = coalescingStates.find(_productId);
+	return _iter == coalescingStates.end() ? 0 : _iter->second.suppressedCount;
+}
+
+template<typename T>
+const PositionMatrix& PositionService<T>::GetPositionMatrix() const
+{
+	return positionMatrix;
+}
+
+template<typename T>
+const map<string, Position<T>>& PositionService<T>::GetPositions() const
+{
+	return positions;
 }
 
 /**
@@ -0,0 +1,590 @@
+/**
+* pretraderiskservice.hpp
+* Defines the data types and Service for pre-trade risk checks on execution orders.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef PRE_TRADE_RISK_SERVICE_HPP
+#define PRE_TRADE_RISK_SERVICE_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <limits>
+#include <cmath>
+#include <unordered_map>
+#include "soa.hpp"
+#include "algoexecutionservice.hpp"
+#include "marketdataservice.hpp"
+#include "positionservice.hpp"
+#include "snapshotpublisher.hpp"
+
+using namespace std;
+
+// Outcomes of a pre-trade risk check
+enum RiskCheckResult { RISK_ACCEPTED, RISK_ORDER_SIZE, RISK_ORDER_NOTIONAL, RISK_PRICE_BAND, RISK_PRODUCT_POSITION, RISK_BOOK_POSITION };
+
+/**
+* Risk limits applying to the orders of a product.
+* Notional is the quantity times the price per 100 face, and the price band is the
+* largest distance of an order price from the mid of the current book.
+*/
+class RiskLimits
+{
+
+public:
+
+	// ctor for risk limits, with no limit by default
+	RiskLimits();
+	RiskLimits(long _maxOrderSize, double _maxNotional, double _priceBand, long _positionLimit);
+
+	// Get the max order size
+	long GetMaxOrderSize() const;
+
+	// Get the max order notional
+	double GetMaxNotional() const;
+
+	// Get the price band around the mid
+	double GetPriceBand() const;
+
+	// Get the limit on the absolute position of the product over all books
+	long GetPositionLimit() const;
+
+private:
+
+	long maxOrderSize;
+	double maxNotional;
+	double priceBand;
+	long positionLimit;
+
+};
+
+RiskLimits::RiskLimits() :
+	maxOrderSize(numeric_limits<long>::max()), maxNotional(numeric_limits<double>::infinity()), priceBand(numeric_limits<double>::infinity()), positionLimit(numeric_limits<long>::max()) {}
+
+RiskLimits::RiskLimits(long _maxOrderSize, double _maxNotional, double _priceBand, long _positionLimit) :
+	maxOrderSize(_maxOrderSize), maxNotional(_maxNotional), priceBand(_priceBand), positionLimit(_positionLimit) {}
+
+long RiskLimits::GetMaxOrderSize() const
+{
+	return maxOrderSize;
+}
+
+double RiskLimits::GetMaxNotional() const
+{
+	return maxNotional;
+}
+
+double RiskLimits::GetPriceBand() const
+{
+	return priceBand;
+}
+
+long RiskLimits::GetPositionLimit() const
+{
+	return positionLimit;
+}
+
+/**
+* Table of risk limits by product with defaults, and of position limits by book.
+* A table is immutable once published to a risk service.
+*/
+class RiskLimitTable
+{
+
+public:
+
+	// ctor for a risk limit table
+	RiskLimitTable() = default;
+
+	// Set the limits of products without limits of their own
+	void SetDefaultLimits(const RiskLimits& _limits);
+
+	// Set the limits of a product
+	void SetProductLimits(const string& _productId, const RiskLimits& _limits);
+
+	// Set the limit on the absolute position of a product in a book
+	void SetBookLimit(const string& _book, long _positionLimit);
+
+	// Get the limits of a product
+	const RiskLimits& GetLimits(const string& _productId) const;
+
+	// Get the position limits by book
+	const vector<pair<string, long>>& GetBookLimits() const;
+
+private:
+
+	RiskLimits defaultLimits;
+	unordered_map<string, RiskLimits> productLimits;
+	vector<pair<string, long>> bookLimits;
+
+};
+
+void RiskLimitTable::SetDefaultLimits(const RiskLimits& _limits)
+{
+	defaultLimits = _limits;
+}
+
+void RiskLimitTable::SetProductLimits(const string& _productId, const RiskLimits& _limits)
+{
+	productLimits[_productId] = _limits;
+}
+
+void RiskLimitTable::SetBookLimit(const string& _book, long _positionLimit)
+{
+	for (auto& b : bookLimits)
+	{
+		if (b.first == _book)
+		{
+			b.second = _positionLimit;
+			return;
+		}
+	}
+	bookLimits.push_back(make_pair(_book, _positionLimit));
+}
+
+const RiskLimits& RiskLimitTable::GetLimits(const string& _productId) const
+{
+	auto _iter = productLimits.find(_productId);
+	return _iter != productLimits.end() ? _iter->second : defaultLimits;
+}
+
+const vector<pair<string, long>>& RiskLimitTable::GetBookLimits() const
+{
+	return bookLimits;
+}
+
+/**
+* Order rejection raised by the pre-trade risk checks.
+* Type T is the product type.
+*/
+template<typename T>
+class OrderRejection
+{
+
+public:
+
+	// ctor for an order rejection
+	OrderRejection() = default;
+	OrderRejection(const ExecutionOrder<T>& _executionOrder, RiskCheckResult _result);
+
+	// Get the rejected order
+	const ExecutionOrder<T>& GetExecutionOrder() const;
+
+	// Get the failed check
+	RiskCheckResult GetResult() const;
+
+	// Change attributes to strings
+	vector<string> ToStrings() const;
+
+private:
+
+	ExecutionOrder<T> executionOrder;
+	RiskCheckResult result;
+
+};
+
+template<typename T>
+OrderRejection<T>::OrderRejection(const ExecutionOrder<T>& _executionOrder, RiskCheckResult _result) :
+	executionOrder(_executionOrder), result(_result) {}
+
+template<typename T>
+const ExecutionOrder<T>& OrderRejection<T>::GetExecutionOrder() const
+{
+	return executionOrder;
+}
+
+template<typename T>
+RiskCheckResult OrderRejection<T>::GetResult() const
+{
+	return result;
+}
+
+template<typename T>
+vector<string> OrderRejection<T>::ToStrings() const
+{
+	string _result;
+	switch (result)
+	{
+	case RISK_ACCEPTED:
+		_result = "ACCEPTED";
+		break;
+	case RISK_ORDER_SIZE:
+		_result = "ORDER_SIZE";
+		break;
+	case RISK_ORDER_NOTIONAL:
+		_result = "ORDER_NOTIONAL";
+		break;
+	case RISK_PRICE_BAND:
+		_result = "PRICE_BAND";
+		break;
+	case RISK_PRODUCT_POSITION:
+		_result = "PRODUCT_POSITION";
+		break;
+	case RISK_BOOK_POSITION:
+		_result = "BOOK_POSITION";
+		break;
+	}
+
+	vector<string> _strings = executionOrder.ToStrings();
+	_strings.push_back(_result);
+	return _strings;
+}
+
+/**
+* Pre-declearations to avoid errors.
+*/
+template<typename T>
+class PreTradeRiskToAlgoExecutionListener;
+template<typename T>
+class PreTradeRiskToPositionListener;
+
+/**
+* Pre-trade risk service checking algo execution orders before they reach execution.
+* Orders passing every check go on to the order listeners, and rejections are
+* published to the listeners of the service.
+* The limit table is read through a snapshot publisher, so checks never lock, and a
+* new table can be published at runtime. A replaced table is freed once no check
+* is still reading it.
+* Keyed on order identifier.
+* Type T is the product type.
+*/
+template<typename T>
+class PreTradeRiskService : public Service<string, OrderRejection<T>>
+{
+
+private:
+
+	struct Exposure
+	{
+		long aggregatePosition;
+		vector<pair<string, long>> bookPositions;
+	};
+
+	map<string, OrderRejection<T>> rejections;
+	vector<ServiceListener<OrderRejection<T>>*> listeners;
+	vector<ServiceListener<AlgoExecution<T>>*> orderListeners;
+	PreTradeRiskToAlgoExecutionListener<T>* listener;
+	PreTradeRiskToPositionListener<T>* positionListener;
+	MarketDataService<T>* marketDataService;
+	unordered_map<string, Exposure> exposures;
+	SnapshotPublisher<RiskLimitTable> limitTables;
+
+public:
+
+	// Constructor and destructor
+	PreTradeRiskService();
+	~PreTradeRiskService();
+
+	// Get data on our service given a key
+	OrderRejection<T>& GetData(string _key);
+
+	// The callback that a Connector should invoke for any new or updated data
+	void OnMessage(OrderRejection<T>& _data);
+
+	// Add a listener to the Service for callbacks on add, remove, and update events for data to the Service
+	void AddListener(ServiceListener<OrderRejection<T>>* _listener);
+
+	// Get all listeners on the Service
+	const vector<ServiceListener<OrderRejection<T>>*>& GetListeners() const;
+
+	// Add a listener for orders passing the checks
+	void AddOrderListener(ServiceListener<AlgoExecution<T>>* _listener);
+
+	// Get the listener of the service
+	PreTradeRiskToAlgoExecutionListener<T>* GetListener();
+
+	// Get the listener of the service on positions
+	PreTradeRiskToPositionListener<T>* GetPositionListener();
+
+	// Set the market data service to read the current book from
+	void SetMarketDataService(MarketDataService<T>* _marketDataService);
+
+	// Publish a new limit table
+	void SetLimitTable(const RiskLimitTable& _limitTable);
+
+	// Get a copy of the current limit table
+	RiskLimitTable GetLimitTable() const;
+
+	// Check an order against the limits
+	RiskCheckResult CheckOrder(const ExecutionOrder<T>& _executionOrder) const;
+
+	// Check an algo execution and pass it on or reject it
+	void ProcessOrder(AlgoExecution<T>& _algoExecution);
+
+	// Update the positions of a product
+	void UpdatePosition(Position<T>& _position);
+
+};
+
+template<typename T>
+PreTradeRiskService<T>::PreTradeRiskService() :
+	limitTables(RiskLimitTable())
+{
+	rejections = map<string, OrderRejection<T>>();
+	listeners = vector<ServiceListener<OrderRejection<T>>*>();
+	orderListeners = vector<ServiceListener<AlgoExecution<T>>*>();
+	listener = new PreTradeRiskToAlgoExecutionListener<T>(this);
+	positionListener = new PreTradeRiskToPositionListener<T>(this);
+	marketDataService = nullptr;
+	exposures = unordered_map<string, Exposure>();
+}
+
+template<typename T>
+PreTradeRiskService<T>::~PreTradeRiskService() {}
+
+template<typename T>
+OrderRejection<T>& PreTradeRiskService<T>::GetData(string _key)
+{
+	return rejections[_key];
+}
+
+template<typename T>
+void PreTradeRiskService<T>::OnMessage(OrderRejection<T>& _data)
+{
+	rejections[_data.GetExecutionOrder().GetOrderId()] = _data;
+}
+
+template<typename T>
+void PreTradeRiskService<T>::AddListener(ServiceListener<OrderRejection<T>>* _listener)
+{
+	listeners.push_back(_listener);
+}
+
+template<typename T>
+const vector<ServiceListener<OrderRejection<T>>*>& PreTradeRiskService<T>::GetListeners() const
+{
+	return listeners;
+}
+
+template<typename T>
+void PreTradeRiskService<T>::AddOrderListener(ServiceListener<AlgoExecution<T>>* _listener)
+{
+	orderListeners.push_back(_listener);
+}
+
+template<typename T>
+PreTradeRiskToAlgoExecutionListener<T>* PreTradeRiskService<T>::GetListener()
+{
+	return listener;
+}
+
+template<typename T>
+PreTradeRiskToPositionListener<T>* PreTradeRiskService<T>::GetPositionListener()
+{
+	return positionListener;
+}
+
+template<typename T>
+void PreTradeRiskService<T>::SetMarketDataService(MarketDataService<T>* _marketDataService)
+{
+	marketDataService = _marketDataService;
+}
+
+template<typename T>
+void PreTradeRiskService<T>::SetLimitTable(const RiskLimitTable& _limitTable)
+{
+	limitTables.Publish(_limitTable);
+}
+
+template<typename T>
+RiskLimitTable PreTradeRiskService<T>::GetLimitTable() const
+{
+	SnapshotReader<RiskLimitTable> _reader(limitTables);
+	return _reader.Get();
+}
+
+template<typename T>
+RiskCheckResult PreTradeRiskService<T>::CheckOrder(const ExecutionOrder<T>& _executionOrder) const
+{
+	SnapshotReader<RiskLimitTable> _reader(limitTables);
+	const RiskLimitTable& _limitTable = _reader.Get();
+	const string& _productId = _executionOrder.GetProduct().GetProductId();
+	const RiskLimits& _limits = _limitTable.GetLimits(_productId);
+	long _quantity = _executionOrder.GetVisibleQuantity() + _executionOrder.GetHiddenQuantity();
+	double _price = _executionOrder.GetPrice();
+
+	if (_quantity > _limits.GetMaxOrderSize()) return RISK_ORDER_SIZE;
+	if (_quantity * _price / 100.0 > _limits.GetMaxNotional()) return RISK_ORDER_NOTIONAL;
+
+	// Orders are only banded when there is a two-sided book to band them against.
+	if (marketDataService)
+	{
+		const TopOfBookTable& _topOfBook = marketDataService->GetTopOfBookTable();
+		long _slot = _topOfBook.FindSlot(_productId);
+		if (_slot >= 0)
+		{
+			double _bidPrice = _topOfBook.GetBidPrices()[_slot];
+			double _offerPrice = _topOfBook.GetOfferPrices()[_slot];
+			if (_bidPrice > 0.0 && _offerPrice > 0.0 && fabs(_price - (_bidPrice + _offerPrice) / 2.0) > _limits.GetPriceBand()) return RISK_PRICE_BAND;
+		}
+	}
+
+	// An order on the bid sells and an order on the offer buys. The book it is
+	// booked into is only known after the fill, so every book limit must hold.
+	long _change = _executionOrder.GetPricingSide() == BID ? -_quantity : _quantity;
+	long _aggregatePosition = 0;
+	const vector<pair<string, long>>* _bookPositions = nullptr;
+	auto _iter = exposures.find(_productId);
+	if (_iter != exposures.end())
+	{
+		_aggregatePosition = _iter->second.aggregatePosition;
+		_bookPositions = &_iter->second.bookPositions;
+	}
+	if (labs(_aggregatePosition + _change) > _limits.GetPositionLimit()) return RISK_PRODUCT_POSITION;
+
+	for (auto& b : _limitTable.GetBookLimits())
+	{
+		long _bookPosition = 0;
+		if (_bookPositions)
+		{
+			for (auto& p : *_bookPositions)
+			{
+				if (p.first == b.first)
+				{
+					_bookPosition = p.second;
+					break;
+				}
+			}
+		}
+		if (labs(_bookPosition + _change) > b.second) return RISK_BOOK_POSITION;
+	}
+	return RISK_ACCEPTED;
+}
+
+template<typename T>
+void PreTradeRiskService<T>::ProcessOrder(AlgoExecution<T>& _algoExecution)
+{
+	const ExecutionOrder<T>& _executionOrder = *_algoExecution.GetExecutionOrder();
+	RiskCheckResult _result = CheckOrder(_executionOrder);
+	if (_result == RISK_ACCEPTED)
+	{
+		for (auto& l : orderListeners)
+		{
+			l->ProcessAdd(_algoExecution);
+		}
+		return;
+	}
+
+	OrderRejection<T> _rejection(_executionOrder, _result);
+	OnMessage(_rejection);
+	for (auto& l : listeners)
+	{
+		l->ProcessAdd(_rejection);
+	}
+}
+
+template<typename T>
+void PreTradeRiskService<T>::UpdatePosition(Position<T>& _position)
+{
+	Exposure& _exposure = exposures[_position.GetProduct().GetProductId()];
+	_exposure.aggregatePosition = _position.GetAggregatePosition();
+	_exposure.bookPositions.clear();
+	for (auto& p : _position.GetPositions())
+	{
+		_exposure.bookPositions.push_back(p);
+	}
+}
+
+/**
+* Pre-Trade Risk Service Listener subscribing data from Algo Execution Service to Pre-Trade Risk Service.
+* Type T is the product type.
+*/
+template<typename T>
+class PreTradeRiskToAlgoExecutionListener : public ServiceListener<AlgoExecution<T>>
+{
+
+private:
+
+	PreTradeRiskService<T>* service;
+
+public:
+
+	// Connector and Destructor
+	PreTradeRiskToAlgoExecutionListener(PreTradeRiskService<T>* _service);
+	~PreTradeRiskToAlgoExecutionListener();
+
+	// Listener callback to process an add event to the Service
+	void ProcessAdd(AlgoExecution<T>& _data);
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(AlgoExecution<T>& _data);
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(AlgoExecution<T>& _data);
+
+};
+
+template<typename T>
+PreTradeRiskToAlgoExecutionListener<T>::PreTradeRiskToAlgoExecutionListener(PreTradeRiskService<T>* _service)
+{
+	service = _service;
+}
+
+template<typename T>
+PreTradeRiskToAlgoExecutionListener<T>::~PreTradeRiskToAlgoExecutionListener() {}
+
+template<typename T>
+void PreTradeRiskToAlgoExecutionListener<T>::ProcessAdd(AlgoExecution<T>& _data)
+{
+	service->ProcessOrder(_data);
+}
+
+template<typename T>
+void PreTradeRiskToAlgoExecutionListener<T>::ProcessRemove(AlgoExecution<T>& _data) {}
+
+template<typename T>
+void PreTradeRiskToAlgoExecutionListener<T>::ProcessUpdate(AlgoExecution<T>& _data) {}
+
+/**
+* Pre-Trade Risk Service Listener subscribing data from Position Service to Pre-Trade Risk Service.
+* Type T is the product type.
+*/
+template<typename T>
+class PreTradeRiskToPositionListener : public ServiceListener<Position<T>>
+{
+
+private:
+
+	PreTradeRiskService<T>* service;
+
+public:
+
+	// Connector and Destructor
+	PreTradeRiskToPositionListener(PreTradeRiskService<T>* _service);
+	~PreTradeRiskToPositionListener();
+
+	// Listener callback to process an add event to the Service
+	void ProcessAdd(Position<T>& _data);
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(Position<T>& _data);
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(Position<T>& _data);
+
+};
+
+template<typename T>
+PreTradeRiskToPositionListener<T>::PreTradeRiskToPositionListener(PreTradeRiskService<T>* _service)
+{
+	service = _service;
+}
+
+template<typename T>
+PreTradeRiskToPositionListener<T>::~PreTradeRiskToPositionListener() {}
+
+template<typename T>
+void PreTradeRiskToPositionListener<T>::ProcessAdd(Position<T>& _data)
+{
+	service->UpdatePosition(_data);
+}
+
+template<typename T>
+void PreTradeRiskToPositionListener<T>::ProcessRemove(Position<T>& _data) {}
+
+template<typename T>
+void PreTradeRiskToPositionListener<T>::ProcessUpdate(Position<T>& _data) {}
+
+#endif
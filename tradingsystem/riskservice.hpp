@@ -147,6 +147,8 @@ class RiskToPositionListener;
 
 /**
 * Risk Service to vend out risk for a particular security and across a risk bucketed sector.
+* Given the Position Service, risk over sectors, books and the desk is read from
+* its position matrix, weighting each product row by its PV01.
 * Keyed on product identifier.
 * Type T is the product type.
 */
@@ -159,6 +161,8 @@ private:
 	map<string, PV01<T>> pv01s;
 	vector<ServiceListener<PV01<T>>*> listeners;
 	RiskToPositionListener<T>* listener;
+	PositionService<T>* positionService;
+	vector<double> pv01Values;
 
 public:
 
@@ -185,7 +189,24 @@ public:
 	void AddPosition(Position<T>& _position);
 
 	// Get the bucketed risk for the bucket sector
-	const PV01<BucketedSector<T>>& GetBucketedRisk(const BucketedSector<T>& _sector) const;
+	PV01<BucketedSector<T>> GetBucketedRisk(const BucketedSector<T>& _sector) const;
+
+	// Set the position service to read positions from
+	void SetPositionService(PositionService<T>* _positionService);
+
+	// Get the risk of a book over all products
+	double GetBookRisk(const string& _book) const;
+
+	// Get the risk over all products and books
+	double GetDeskRisk() const;
+
+	// Get the risk of all products
+	const map<string, PV01<T>>& GetPV01s() const;
+
+private:
+
+	// Keep the PV01 of a product row of the position matrix
+	void SetPV01Value(const string& _productId, double _pv01Value);
 
 };
 
@@ -195,6 +216,8 @@ RiskService<T>::RiskService()
 	pv01s = map<string, PV01<T>>();
 	listeners = vector<ServiceListener<PV01<T>>*>();
 	listener = new RiskToPositionListener<T>(this);
+	positionService = nullptr;
+	pv01Values = vector<double>();
 }
 
 template<typename T>
@@ -210,6 +233,7 @@ template<typename T>
 void RiskService<T>::OnMessage(PV01<T>& _data)
 {
 	pv01s[_data.GetProduct().GetProductId()] = _data;
+	SetPV01Value(_data.GetProduct().GetProductId(), _data.GetPV01());
 }
 
 template<typename T>
@@ -239,6 +263,7 @@ void RiskService<T>::AddPosition(Position<T>& _position)
 	long _quantity = _position.GetAggregatePosition();
 	PV01<T> _pv01(_product, _pv01Value, _quantity);
 	pv01s[_productId] = _pv01;
+	SetPV01Value(_productId, _pv01Value);
 
 	for (auto& l : listeners)
 	{
@@ -247,22 +272,89 @@ void RiskService<T>::AddPosition(Position<T>& _position)
 }
 
 template<typename T>
-const PV01<BucketedSector<T>>& RiskService<T>::GetBucketedRisk(const BucketedSector<T>& _sector) const
+PV01<BucketedSector<T>> RiskService<T>::GetBucketedRisk(const BucketedSector<T>& _sector) const
 {
 	BucketedSector<T> _product = _sector;
 	double _pv01 = 0;
 	long _quantity = 1;
 
-	vector<T>& _products = _sector.GetProducts();
+	const vector<T>& _products = _sector.GetProducts();
 	for (auto& p : _products)
 	{
-		string _pId = p.GetProductId();
-		_pv01 += pv01s[_pId].GetPV01() * pv01s[_pId].GetQuantity();
+		const string& _pId = p.GetProductId();
+		if (positionService)
+		{
+			const PositionMatrix& _matrix = positionService->GetPositionMatrix();
+			long _productRow = _matrix.FindProduct(_pId);
+			if (_productRow >= 0 && _productRow < (long)pv01Values.size())
+			{
+				_pv01 += pv01Values[_productRow] * _matrix.GetProductPosition(_productRow);
+			}
+			continue;
+		}
+		auto _iter = pv01s.find(_pId);
+		if (_iter != pv01s.end()) _pv01 += _iter->second.GetPV01() * _iter->second.GetQuantity();
 	}
 
 	return PV01<BucketedSector<T>>(_product, _pv01, _quantity);
 }
 
+template<typename T>
+void RiskService<T>::SetPositionService(PositionService<T>* _positionService)
+{
+	positionService = _positionService;
+}
+
+template<typename T>
+void RiskService<T>::SetPV01Value(const string& _productId, double _pv01Value)
+{
+	if (!positionService) return;
+	long _productRow = positionService->GetPositionMatrix().FindProduct(_productId);
+	if (_productRow < 0) return;
+	if (_productRow >= (long)pv01Values.size()) pv01Values.resize(_productRow + 1, 0.0);
+	pv01Values[_productRow] = _pv01Value;
+}
+
+template<typename T>
+double RiskService<T>::GetBookRisk(const string& _book) const
+{
+	if (!positionService) return 0.0;
+	const PositionMatrix& _matrix = positionService->GetPositionMatrix();
+	long _bookId = _matrix.GetBookRegistry().FindBook(_book);
+	if (_bookId < 0) return 0.0;
+
+	double _risk = 0.0;
+	long _productCount = min(_matrix.GetProductCount(), (long)pv01Values.size());
+	for (long r = 0; r < _productCount; r++)
+	{
+		_risk += pv01Values[r] * _matrix.GetPosition(r, _bookId);
+	}
+	return _risk;
+}
+
+template<typename T>
+double RiskService<T>::GetDeskRisk() const
+{
+	if (!positionService) return 0.0;
+	vector<long long> _productPositions;
+	vector<long long> _bookPositions;
+	positionService->GetPositionMatrix().Aggregate(_productPositions, _bookPositions);
+
+	double _risk = 0.0;
+	long _productCount = min((long)_productPositions.size(), (long)pv01Values.size());
+	for (long r = 0; r < _productCount; r++)
+	{
+		_risk += pv01Values[r] * _productPositions[r];
+	}
+	return _risk;
+}
+
+template<typename T>
+const map<string, PV01<T>>& RiskService<T>::GetPV01s() const
+{
+	return pv01s;
+}
+
 /**
 * Risk Service Listener subscribing data from Position Service to Risk Service.
 * Type T is the product type.
@@ -0,0 +1,301 @@
+/**
+* smartorderrouter.hpp
+* Defines the smart order router splitting execution orders across venues.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef SMART_ORDER_ROUTER_HPP
+#define SMART_ORDER_ROUTER_HPP
+
+#include <string>
+#include <array>
+#include <algorithm>
+#include <unordered_map>
+#include "soa.hpp"
+#include "algoexecutionservice.hpp"
+#include "marketdataservice.hpp"
+
+using namespace std;
+
+// Number of venues in the Market enum
+const int VENUE_COUNT = 3;
+
+/**
+* Quantities of an order routed to each venue, indexed by Market.
+*/
+class RoutingDecision
+{
+
+public:
+
+	// ctor for a routing decision with nothing routed
+	RoutingDecision();
+
+	// Get the quantity routed to a venue
+	long GetQuantity(Market _market) const;
+
+	// Add quantity routed to a venue
+	void AddQuantity(Market _market, long _quantity);
+
+	// Get the quantity routed over all venues
+	long GetTotalQuantity() const;
+
+private:
+
+	array<long, VENUE_COUNT> quantities;
+
+};
+
+RoutingDecision::RoutingDecision()
+{
+	quantities.fill(0);
+}
+
+long RoutingDecision::GetQuantity(Market _market) const
+{
+	return quantities[_market];
+}
+
+void RoutingDecision::AddQuantity(Market _market, long _quantity)
+{
+	quantities[_market] += _quantity;
+}
+
+long RoutingDecision::GetTotalQuantity() const
+{
+	long _total = 0;
+	for (auto& q : quantities) _total += q;
+	return _total;
+}
+
+/**
+* Pre-declearations to avoid errors.
+*/
+template<typename T, size_t N = 5>
+class SmartOrderRouterToMarketDataListener;
+
+/**
+* Smart order router splitting an order across venues by the size and price on
+* offer at each venue when it is sent.
+* Each venue keeps the best aggregated bid and offer of every product, refreshed
+* as its books update, so a routing decision looks at VENUE_COUNT levels and never
+* walks a book. Venues are ranked by price net of their fee per 100 face, with
+* the likelier fill first on a tie, and each takes the size it is expected to fill,
+* its displayed size scaled by its fill probability. Whatever is left after the
+* last venue goes to the best ranked one, or to the default venue when no venue
+* can take the order at its price.
+* Books of any depth update a venue. The listeners of the router take books of the
+* default depth, and a listener of another depth can be made on it.
+* Type T is the product type.
+*/
+template<typename T>
+class SmartOrderRouter
+{
+
+public:
+
+	// ctor for a smart order router
+	SmartOrderRouter();
+
+	// Set the fee per 100 face and the fill probability of a venue
+	void SetVenue(Market _market, double _fee, double _fillProbability);
+
+	// Set the venue taking orders that no venue can take
+	void SetDefaultVenue(Market _market);
+
+	// Get the listener updating the best levels of a venue
+	SmartOrderRouterToMarketDataListener<T>* GetListener(Market _market);
+
+	// Update the best levels of a product on a venue
+	template<size_t N>
+	void UpdateVenue(Market _market, const OrderBook<T, N>& _orderBook);
+
+	// Route an order across the venues
+	RoutingDecision RouteOrder(const ExecutionOrder<T>& _executionOrder) const;
+
+private:
+
+	struct VenueLevel
+	{
+		double bidPrice;
+		long bidQuantity;
+		double offerPrice;
+		long offerQuantity;
+	};
+
+	unordered_map<string, array<VenueLevel, VENUE_COUNT>> venueLevels;
+	array<double, VENUE_COUNT> fees;
+	array<double, VENUE_COUNT> fillProbabilities;
+	array<SmartOrderRouterToMarketDataListener<T>*, VENUE_COUNT> listeners;
+	Market defaultVenue;
+
+};
+
+template<typename T>
+SmartOrderRouter<T>::SmartOrderRouter()
+{
+	venueLevels = unordered_map<string, array<VenueLevel, VENUE_COUNT>>();
+	fees.fill(0.0);
+	fillProbabilities.fill(1.0);
+	for (int i = 0; i < VENUE_COUNT; i++)
+	{
+		listeners[i] = new SmartOrderRouterToMarketDataListener<T>(this, (Market)i);
+	}
+	defaultVenue = BROKERTEC;
+}
+
+template<typename T>
+void SmartOrderRouter<T>::SetVenue(Market _market, double _fee, double _fillProbability)
+{
+	fees[_market] = _fee;
+	fillProbabilities[_market] = _fillProbability;
+}
+
+template<typename T>
+void SmartOrderRouter<T>::SetDefaultVenue(Market _market)
+{
+	defaultVenue = _market;
+}
+
+template<typename T>
+SmartOrderRouterToMarketDataListener<T>* SmartOrderRouter<T>::GetListener(Market _market)
+{
+	return listeners[_market];
+}
+
+template<typename T>
+template<size_t N>
+void SmartOrderRouter<T>::UpdateVenue(Market _market, const OrderBook<T, N>& _orderBook)
+{
+	auto _iter = venueLevels.find(_orderBook.GetProduct().GetProductId());
+	if (_iter == venueLevels.end())
+	{
+		array<VenueLevel, VENUE_COUNT> _levels;
+		_levels.fill(VenueLevel{ 0.0, 0, 0.0, 0 });
+		_iter = venueLevels.insert(make_pair(_orderBook.GetProduct().GetProductId(), _levels)).first;
+	}
+
+	BidOffer _bidOffer = _orderBook.Aggregate().GetBidOffer();
+	VenueLevel& _level = _iter->second[_market];
+	_level.bidPrice = _bidOffer.GetBidOrder().GetPrice();
+	_level.bidQuantity = _bidOffer.GetBidOrder().GetQuantity();
+	_level.offerPrice = _bidOffer.GetOfferOrder().GetPrice();
+	_level.offerQuantity = _bidOffer.GetOfferOrder().GetQuantity();
+}
+
+template<typename T>
+RoutingDecision SmartOrderRouter<T>::RouteOrder(const ExecutionOrder<T>& _executionOrder) const
+{
+	RoutingDecision _decision;
+	long _quantity = _executionOrder.GetVisibleQuantity() + _executionOrder.GetHiddenQuantity();
+	auto _iter = venueLevels.find(_executionOrder.GetProduct().GetProductId());
+	if (_iter == venueLevels.end())
+	{
+		_decision.AddQuantity(defaultVenue, _quantity);
+		return _decision;
+	}
+
+	// An order on the bid sells into the bids, an order on the offer buys from the offers.
+	bool _isBuy = _executionOrder.GetPricingSide() == OFFER;
+	bool _hasLimit = _executionOrder.GetOrderType() != MARKET;
+	double _limitPrice = _executionOrder.GetPrice();
+
+	array<int, VENUE_COUNT> _ranks;
+	array<double, VENUE_COUNT> _netPrices;
+	array<long, VENUE_COUNT> _sizes;
+	int _count = 0;
+	for (int i = 0; i < VENUE_COUNT; i++)
+	{
+		const VenueLevel& _level = _iter->second[i];
+		double _price = _isBuy ? _level.offerPrice : _level.bidPrice;
+		long _size = _isBuy ? _level.offerQuantity : _level.bidQuantity;
+		if (_size <= 0) continue;
+		if (_hasLimit && (_isBuy ? _price > _limitPrice : _price < _limitPrice)) continue;
+
+		// Buying costs the fee on top, selling gives it up, so a lower net price ranks first either way.
+		_netPrices[i] = _isBuy ? _price + fees[i] : -(_price - fees[i]);
+		_sizes[i] = (long)(_size * fillProbabilities[i]);
+
+		int j = _count++;
+		while (j > 0)
+		{
+			int k = _ranks[j - 1];
+			if (_netPrices[k] < _netPrices[i] || (_netPrices[k] == _netPrices[i] && fillProbabilities[k] >= fillProbabilities[i])) break;
+			_ranks[j] = k;
+			j--;
+		}
+		_ranks[j] = i;
+	}
+
+	if (_count == 0)
+	{
+		_decision.AddQuantity(defaultVenue, _quantity);
+		return _decision;
+	}
+
+	long _remaining = _quantity;
+	for (int j = 0; j < _count && _remaining > 0; j++)
+	{
+		long _routed = min(_remaining, _sizes[_ranks[j]]);
+		_decision.AddQuantity((Market)_ranks[j], _routed);
+		_remaining -= _routed;
+	}
+	if (_remaining > 0) _decision.AddQuantity((Market)_ranks[0], _remaining);
+	return _decision;
+}
+
+/**
+* Smart Order Router Listener subscribing the books of one venue from Market Data Service.
+* Type T is the product type.
+* N is the book depth.
+*/
+template<typename T, size_t N>
+class SmartOrderRouterToMarketDataListener : public ServiceListener<OrderBook<T, N>>
+{
+
+private:
+
+	SmartOrderRouter<T>* service;
+	Market market;
+
+public:
+
+	// Connector and Destructor
+	SmartOrderRouterToMarketDataListener(SmartOrderRouter<T>* _service, Market _market);
+	~SmartOrderRouterToMarketDataListener();
+
+	// Listener callback to process an add event to the Service
+	void ProcessAdd(OrderBook<T, N>& _data);
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(OrderBook<T, N>& _data);
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(OrderBook<T, N>& _data);
+
+};
+
+template<typename T, size_t N>
+SmartOrderRouterToMarketDataListener<T, N>::SmartOrderRouterToMarketDataListener(SmartOrderRouter<T>* _service, Market _market)
+{
+	service = _service;
+	market = _market;
+}
+
+template<typename T, size_t N>
+SmartOrderRouterToMarketDataListener<T, N>::~SmartOrderRouterToMarketDataListener() {}
+
+template<typename T, size_t N>
+void SmartOrderRouterToMarketDataListener<T, N>::ProcessAdd(OrderBook<T, N>& _data)
+{
+	service->UpdateVenue(market, _data);
+}
+
+template<typename T, size_t N>
+void SmartOrderRouterToMarketDataListener<T, N>::ProcessRemove(OrderBook<T, N>& _data) {}
+
+template<typename T, size_t N>
+void SmartOrderRouterToMarketDataListener<T, N>::ProcessUpdate(OrderBook<T, N>& _data) {}
+
+#endif
@@ -0,0 +1,230 @@
+/**
+* snapshotpublisher.hpp
+* Defines the publisher of read-only tables swapped at runtime and read without locks.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef SNAPSHOT_PUBLISHER_HPP
+#define SNAPSHOT_PUBLISHER_HPP
+
+#include <vector>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <limits>
+#include <functional>
+
+using namespace std;
+
+/**
+* Pre-declearations to avoid errors.
+*/
+template<typename S>
+class SnapshotReader;
+
+/**
+* Publisher of a read-only table that readers on any thread see without locking.
+* The current table is behind an atomic pointer, and publishing a new one swaps
+* the pointer and retires the old table under the epoch it was replaced in.
+* A reader holds one of READER_SLOTS slots while it reads, marked with the epoch
+* it started in, so a retired table is freed at the next publish once every reader
+* holding a slot started after it was replaced. Memory is then bounded by the
+* tables still being read rather than by the number of tables ever published.
+* Each table carries a version, increasing with every publish, which readers can
+* cache against instead of the address of a table that may be freed and reused.
+* Type S is the table type.
+*/
+template<typename S>
+class SnapshotPublisher
+{
+
+public:
+
+	// Most readers holding a table at once
+	static const int READER_SLOTS = 64;
+
+	// ctor for a publisher of a first table
+	SnapshotPublisher(const S& _table);
+	~SnapshotPublisher();
+
+	// Publish a new table, and free the retired tables no reader holds any more
+	void Publish(const S& _table);
+
+	// Get the number of tables replaced but not freed yet
+	long GetRetiredCount() const;
+
+private:
+
+	friend class SnapshotReader<S>;
+
+	struct Snapshot
+	{
+		S table;
+		long long version;
+	};
+
+	// One slot per cache line, so readers on different threads do not share a line.
+	struct alignas(64) ReaderSlot
+	{
+		atomic<unsigned long long> epoch;
+	};
+
+	atomic<Snapshot*> current;
+	atomic<unsigned long long> epoch;
+	mutable array<ReaderSlot, READER_SLOTS> readerSlots;
+	vector<pair<Snapshot*, unsigned long long>> retired;
+	long long version;
+	mutable mutex publishMutex;
+
+	// Take a free reader slot marked with the current epoch, and get its index
+	int Enter() const;
+
+	// Give back a reader slot
+	void Exit(int _slot) const;
+
+	// Free the retired tables replaced before the oldest reader started
+	void Reclaim();
+
+};
+
+template<typename S>
+SnapshotPublisher<S>::SnapshotPublisher(const S& _table)
+{
+	// Epochs start at 1, so a slot at 0 is free.
+	epoch = 1;
+	for (auto& s : readerSlots)
+	{
+		s.epoch = 0;
+	}
+	version = 1;
+	current = new Snapshot{ _table, version };
+	retired = vector<pair<Snapshot*, unsigned long long>>();
+}
+
+template<typename S>
+SnapshotPublisher<S>::~SnapshotPublisher()
+{
+	for (auto& r : retired)
+	{
+		delete r.first;
+	}
+	delete current.load();
+}
+
+template<typename S>
+void SnapshotPublisher<S>::Publish(const S& _table)
+{
+	lock_guard<mutex> _lock(publishMutex);
+	Snapshot* _replaced = current.exchange(new Snapshot{ _table, ++version });
+
+	// A reader that started before the new epoch may still hold the replaced table.
+	unsigned long long _epoch = epoch.fetch_add(1) + 1;
+	retired.push_back(make_pair(_replaced, _epoch));
+	Reclaim();
+}
+
+template<typename S>
+long SnapshotPublisher<S>::GetRetiredCount() const
+{
+	lock_guard<mutex> _lock(publishMutex);
+	return retired.size();
+}
+
+template<typename S>
+int SnapshotPublisher<S>::Enter() const
+{
+	// Each thread starts looking from its own slot, so readers seldom contend for one.
+	static thread_local int _start = (int)(hash<thread::id>()(this_thread::get_id()) % READER_SLOTS);
+	unsigned long long _epoch = epoch.load();
+	for (int i = _start; ; i = (i + 1) % READER_SLOTS)
+	{
+		unsigned long long _free = 0;
+		if (readerSlots[i].epoch.compare_exchange_strong(_free, _epoch)) return i;
+	}
+}
+
+template<typename S>
+void SnapshotPublisher<S>::Exit(int _slot) const
+{
+	readerSlots[_slot].epoch.store(0, memory_order_release);
+}
+
+template<typename S>
+void SnapshotPublisher<S>::Reclaim()
+{
+	unsigned long long _oldest = numeric_limits<unsigned long long>::max();
+	for (auto& s : readerSlots)
+	{
+		unsigned long long _epoch = s.epoch.load();
+		if (_epoch != 0 && _epoch < _oldest) _oldest = _epoch;
+	}
+
+	size_t _kept = 0;
+	for (size_t i = 0; i < retired.size(); i++)
+	{
+		if (retired[i].second <= _oldest) delete retired[i].first;
+		else retired[_kept++] = retired[i];
+	}
+	retired.resize(_kept);
+}
+
+/**
+* Reader holding the current table of a snapshot publisher for as long as it lives.
+* Type S is the table type.
+*/
+template<typename S>
+class SnapshotReader
+{
+
+public:
+
+	// ctor for a reader of the current table of a publisher
+	SnapshotReader(const SnapshotPublisher<S>& _publisher);
+	~SnapshotReader();
+
+	SnapshotReader(const SnapshotReader&) = delete;
+	SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+	// Get the table
+	const S& Get() const;
+
+	// Get the version of the table
+	long long GetVersion() const;
+
+private:
+
+	const SnapshotPublisher<S>& publisher;
+	int slot;
+	const typename SnapshotPublisher<S>::Snapshot* snapshot;
+
+};
+
+template<typename S>
+SnapshotReader<S>::SnapshotReader(const SnapshotPublisher<S>& _publisher) :
+	publisher(_publisher)
+{
+	slot = publisher.Enter();
+	snapshot = publisher.current.load();
+}
+
+template<typename S>
+SnapshotReader<S>::~SnapshotReader()
+{
+	publisher.Exit(slot);
+}
+
+template<typename S>
+const S& SnapshotReader<S>::Get() const
+{
+	return snapshot->table;
+}
+
+template<typename S>
+long long SnapshotReader<S>::GetVersion() const
+{
+	return snapshot->version;
+}
+
+#endif
@@ -0,0 +1,493 @@
+/**
+* tickstoreservice.hpp
+* Defines the data types and Service for storing historical order book ticks.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef TICK_STORE_SERVICE_HPP
+#define TICK_STORE_SERVICE_HPP
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "soa.hpp"
+#include "marketdataservice.hpp"
+
+using namespace std;
+
+/**
+* Append-only columnar tick store of order book updates for a single product.
+* Every update gets a time stamp. A full snapshot is kept every snapshotInterval
+* updates and only the changed levels are kept for the updates in between.
+* Type T is the product type.
+* N is the book depth.
+*/
+template<typename T, size_t N = 5>
+class OrderBookTickStore
+{
+
+public:
+
+	// ctor for a tick store
+	OrderBookTickStore();
+	OrderBookTickStore(const T& _product, long _snapshotInterval);
+
+	// Get the product
+	const T& GetProduct() const;
+
+	// Get the number of updates stored
+	long GetUpdateCount() const;
+
+	// Get the number of changed levels stored as deltas
+	long GetDeltaCount() const;
+
+	// Get the time stamp of an update
+	long long GetTime(long _update) const;
+
+	// Append an order book update with its time stamp, moved up to the last one if it goes backwards
+	void Append(const OrderBook<T, N>& _orderBook, long long _time);
+
+	// Get the index of the last update at or before a time, or -1 if there is none
+	long FindUpdate(long long _time) const;
+
+	// Get the range [first, last) of updates with time stamps in [start, end]
+	pair<long, long> FindUpdates(long long _start, long long _end) const;
+
+	// Rebuild the order book as of an update
+	OrderBook<T, N> GetBook(long _update) const;
+
+	// Rebuild the order book as of a time
+	OrderBook<T, N> GetBookAsOf(long long _time) const;
+
+	// Replay the updates with time stamps in [start, end] to a listener in order
+	long Replay(long long _start, long long _end, ServiceListener<OrderBook<T, N>>* _listener) const;
+
+private:
+	T product;
+	long snapshotInterval;
+
+	// One entry per update.
+	vector<long long> times;
+	vector<long> deltaOffsets;
+
+	// One entry per level of each snapshot, row = snapshot * N + level.
+	vector<double> snapshotBidPrices;
+	vector<long> snapshotBidQuantities;
+	vector<double> snapshotOfferPrices;
+	vector<long> snapshotOfferQuantities;
+
+	// One entry per changed level.
+	vector<unsigned char> deltaLevels;
+	vector<unsigned char> deltaSides;
+	vector<double> deltaPrices;
+	vector<long> deltaQuantities;
+
+	// Last book appended, used to compute deltas.
+	array<Order, N> lastBidStack;
+	array<Order, N> lastOfferStack;
+
+	// Apply the deltas of an update to a pair of stacks
+	void ApplyDeltas(long _update, array<Order, N>& _bidStack, array<Order, N>& _offerStack) const;
+
+};
+
+template<typename T, size_t N>
+OrderBookTickStore<T, N>::OrderBookTickStore()
+{
+	snapshotInterval = 1;
+	deltaOffsets.push_back(0);
+	lastBidStack.fill(Order(0.0, 0, BID));
+	lastOfferStack.fill(Order(0.0, 0, OFFER));
+}
+
+template<typename T, size_t N>
+OrderBookTickStore<T, N>::OrderBookTickStore(const T& _product, long _snapshotInterval) :
+	product(_product)
+{
+	snapshotInterval = _snapshotInterval;
+	deltaOffsets.push_back(0);
+	lastBidStack.fill(Order(0.0, 0, BID));
+	lastOfferStack.fill(Order(0.0, 0, OFFER));
+}
+
+template<typename T, size_t N>
+const T& OrderBookTickStore<T, N>::GetProduct() const
+{
+	return product;
+}
+
+template<typename T, size_t N>
+long OrderBookTickStore<T, N>::GetUpdateCount() const
+{
+	return times.size();
+}
+
+template<typename T, size_t N>
+long OrderBookTickStore<T, N>::GetDeltaCount() const
+{
+	return deltaPrices.size();
+}
+
+template<typename T, size_t N>
+long long OrderBookTickStore<T, N>::GetTime(long _update) const
+{
+	return times[_update];
+}
+
+template<typename T, size_t N>
+void OrderBookTickStore<T, N>::Append(const OrderBook<T, N>& _orderBook, long long _time)
+{
+	const array<Order, N>& _bidStack = _orderBook.GetBidStack();
+	const array<Order, N>& _offerStack = _orderBook.GetOfferStack();
+	long _update = times.size();
+
+	// Times are kept sorted for the searches, so a clock stepping back is held at the last time.
+	if (!times.empty() && _time < times.back()) _time = times.back();
+	times.push_back(_time);
+
+	if (_update % snapshotInterval == 0)
+	{
+		for (size_t i = 0; i < N; i++)
+		{
+			snapshotBidPrices.push_back(_bidStack[i].GetPrice());
+			snapshotBidQuantities.push_back(_bidStack[i].GetQuantity());
+			snapshotOfferPrices.push_back(_offerStack[i].GetPrice());
+			snapshotOfferQuantities.push_back(_offerStack[i].GetQuantity());
+		}
+	}
+	else
+	{
+		for (size_t i = 0; i < N; i++)
+		{
+			if (_bidStack[i].GetPrice() != lastBidStack[i].GetPrice() || _bidStack[i].GetQuantity() != lastBidStack[i].GetQuantity())
+			{
+				deltaLevels.push_back((unsigned char)i);
+				deltaSides.push_back(BID);
+				deltaPrices.push_back(_bidStack[i].GetPrice());
+				deltaQuantities.push_back(_bidStack[i].GetQuantity());
+			}
+			if (_offerStack[i].GetPrice() != lastOfferStack[i].GetPrice() || _offerStack[i].GetQuantity() != lastOfferStack[i].GetQuantity())
+			{
+				deltaLevels.push_back((unsigned char)i);
+				deltaSides.push_back(OFFER);
+				deltaPrices.push_back(_offerStack[i].GetPrice());
+				deltaQuantities.push_back(_offerStack[i].GetQuantity());
+			}
+		}
+	}
+	deltaOffsets.push_back(deltaPrices.size());
+
+	lastBidStack = _bidStack;
+	lastOfferStack = _offerStack;
+}
+
+template<typename T, size_t N>
+long OrderBookTickStore<T, N>::FindUpdate(long long _time) const
+{
+	auto _iter = upper_bound(times.begin(), times.end(), _time);
+	return (long)(_iter - times.begin()) - 1;
+}
+
+template<typename T, size_t N>
+pair<long, long> OrderBookTickStore<T, N>::FindUpdates(long long _start, long long _end) const
+{
+	long _first = lower_bound(times.begin(), times.end(), _start) - times.begin();
+	long _last = upper_bound(times.begin(), times.end(), _end) - times.begin();
+	if (_last < _first) _last = _first;
+	return make_pair(_first, _last);
+}
+
+template<typename T, size_t N>
+void OrderBookTickStore<T, N>::ApplyDeltas(long _update, array<Order, N>& _bidStack, array<Order, N>& _offerStack) const
+{
+	for (long d = deltaOffsets[_update]; d < deltaOffsets[_update + 1]; d++)
+	{
+		PricingSide _side = (PricingSide)deltaSides[d];
+		Order _order(deltaPrices[d], deltaQuantities[d], _side);
+		switch (_side)
+		{
+		case BID:
+			_bidStack[deltaLevels[d]] = _order;
+			break;
+		case OFFER:
+			_offerStack[deltaLevels[d]] = _order;
+			break;
+		}
+	}
+}
+
+template<typename T, size_t N>
+OrderBook<T, N> OrderBookTickStore<T, N>::GetBook(long _update) const
+{
+	long _snapshot = _update / snapshotInterval;
+	array<Order, N> _bidStack;
+	array<Order, N> _offerStack;
+	for (size_t i = 0; i < N; i++)
+	{
+		long _row = _snapshot * N + i;
+		_bidStack[i] = Order(snapshotBidPrices[_row], snapshotBidQuantities[_row], BID);
+		_offerStack[i] = Order(snapshotOfferPrices[_row], snapshotOfferQuantities[_row], OFFER);
+	}
+	for (long u = _snapshot * snapshotInterval + 1; u <= _update; u++)
+	{
+		ApplyDeltas(u, _bidStack, _offerStack);
+	}
+	return OrderBook<T, N>(product, _bidStack, _offerStack);
+}
+
+template<typename T, size_t N>
+OrderBook<T, N> OrderBookTickStore<T, N>::GetBookAsOf(long long _time) const
+{
+	long _update = FindUpdate(_time);
+	if (_update < 0)
+	{
+		array<Order, N> _bidStack;
+		array<Order, N> _offerStack;
+		_bidStack.fill(Order(0.0, 0, BID));
+		_offerStack.fill(Order(0.0, 0, OFFER));
+		return OrderBook<T, N>(product, _bidStack, _offerStack);
+	}
+	return GetBook(_update);
+}
+
+template<typename T, size_t N>
+long OrderBookTickStore<T, N>::Replay(long long _start, long long _end, ServiceListener<OrderBook<T, N>>* _listener) const
+{
+	pair<long, long> _range = FindUpdates(_start, _end);
+	if (_range.first == _range.second) return 0;
+
+	// Rebuild the first book once, then roll the deltas forward.
+	OrderBook<T, N> _orderBook = GetBook(_range.first);
+	array<Order, N> _bidStack = _orderBook.GetBidStack();
+	array<Order, N> _offerStack = _orderBook.GetOfferStack();
+	_listener->ProcessAdd(_orderBook);
+	for (long u = _range.first + 1; u < _range.second; u++)
+	{
+		if (u % snapshotInterval == 0)
+		{
+			_orderBook = GetBook(u);
+			_bidStack = _orderBook.GetBidStack();
+			_offerStack = _orderBook.GetOfferStack();
+		}
+		else
+		{
+			ApplyDeltas(u, _bidStack, _offerStack);
+			_orderBook = OrderBook<T, N>(product, _bidStack, _offerStack);
+		}
+		_listener->ProcessAdd(_orderBook);
+	}
+	return _range.second - _range.first;
+}
+
+/**
+* Pre-declearations to avoid errors.
+*/
+template<typename T, size_t N = 5>
+class TickStoreToMarketDataListener;
+
+/**
+* Tick Store Service keeping every order book update in a per-product tick store.
+* A snapshot interval below 1 is rejected, and the default of 100 updates kept.
+* Keyed on product identifier.
+* Type T is the product type.
+* N is the book depth.
+*/
+template<typename T, size_t N = 5>
+class TickStoreService : public Service<string, OrderBook<T, N>>
+{
+
+private:
+
+	map<string, OrderBook<T, N>> orderBooks;
+	map<string, OrderBookTickStore<T, N>> tickStores;
+	vector<ServiceListener<OrderBook<T, N>>*> listeners;
+	TickStoreToMarketDataListener<T, N>* listener;
+	long snapshotInterval;
+
+public:
+
+	// Constructor and destructor
+	TickStoreService();
+	TickStoreService(long _snapshotInterval);
+	~TickStoreService();
+
+	// Get data on our service given a key
+	OrderBook<T, N>& GetData(string _key);
+
+	// The callback that a Connector should invoke for any new or updated data
+	void OnMessage(OrderBook<T, N>& _data);
+
+	// Add a listener to the Service for callbacks on add, remove, and update events for data to the Service
+	void AddListener(ServiceListener<OrderBook<T, N>>* _listener);
+
+	// Get all listeners on the Service
+	const vector<ServiceListener<OrderBook<T, N>>*>& GetListeners() const;
+
+	// Get the listener of the service
+	TickStoreToMarketDataListener<T, N>* GetListener();
+
+	// Store an order book update with a time stamp
+	void StoreBook(OrderBook<T, N>& _orderBook, long long _time);
+
+	// Get the tick store of a product, empty if it has no updates
+	const OrderBookTickStore<T, N>& GetTickStore(const string& _productId);
+
+	// Rebuild the order book of a product as of a time, empty if it has no updates
+	OrderBook<T, N> GetBookAsOf(const string& _productId, long long _time);
+
+	// Replay the updates of a product with time stamps in [start, end] to a listener
+	long Replay(const string& _productId, long long _start, long long _end, ServiceListener<OrderBook<T, N>>* _listener);
+
+};
+
+template<typename T, size_t N>
+TickStoreService<T, N>::TickStoreService()
+{
+	orderBooks = map<string, OrderBook<T, N>>();
+	tickStores = map<string, OrderBookTickStore<T, N>>();
+	listeners = vector<ServiceListener<OrderBook<T, N>>*>();
+	listener = new TickStoreToMarketDataListener<T, N>(this);
+	snapshotInterval = 100;
+}
+
+template<typename T, size_t N>
+TickStoreService<T, N>::TickStoreService(long _snapshotInterval)
+{
+	orderBooks = map<string, OrderBook<T, N>>();
+	tickStores = map<string, OrderBookTickStore<T, N>>();
+	listeners = vector<ServiceListener<OrderBook<T, N>>*>();
+	listener = new TickStoreToMarketDataListener<T, N>(this);
+	snapshotInterval = _snapshotInterval < 1 ? 100 : _snapshotInterval;
+}
+
+template<typename T, size_t N>
+TickStoreService<T, N>::~TickStoreService() {}
+
+template<typename T, size_t N>
+OrderBook<T, N>& TickStoreService<T, N>::GetData(string _key)
+{
+	return orderBooks[_key];
+}
+
+template<typename T, size_t N>
+void TickStoreService<T, N>::OnMessage(OrderBook<T, N>& _data)
+{
+	StoreBook(_data, GetEpochMicrosecond());
+}
+
+template<typename T, size_t N>
+void TickStoreService<T, N>::AddListener(ServiceListener<OrderBook<T, N>>* _listener)
+{
+	listeners.push_back(_listener);
+}
+
+template<typename T, size_t N>
+const vector<ServiceListener<OrderBook<T, N>>*>& TickStoreService<T, N>::GetListeners() const
+{
+	return listeners;
+}
+
+template<typename T, size_t N>
+TickStoreToMarketDataListener<T, N>* TickStoreService<T, N>::GetListener()
+{
+	return listener;
+}
+
+template<typename T, size_t N>
+void TickStoreService<T, N>::StoreBook(OrderBook<T, N>& _orderBook, long long _time)
+{
+	const T& _product = _orderBook.GetProduct();
+	string _productId = _product.GetProductId();
+	orderBooks[_productId] = _orderBook;
+
+	auto _iter = tickStores.find(_productId);
+	if (_iter == tickStores.end())
+	{
+		_iter = tickStores.insert(make_pair(_productId, OrderBookTickStore<T, N>(_product, snapshotInterval))).first;
+	}
+	_iter->second.Append(_orderBook, _time);
+
+	for (auto& l : listeners)
+	{
+		l->ProcessAdd(_orderBook);
+	}
+}
+
+template<typename T, size_t N>
+const OrderBookTickStore<T, N>& TickStoreService<T, N>::GetTickStore(const string& _productId)
+{
+	auto _iter = tickStores.find(_productId);
+	if (_iter != tickStores.end()) return _iter->second;
+
+	// Unknown products get an empty store rather than one in the map.
+	static const OrderBookTickStore<T, N> _emptyTickStore;
+	return _emptyTickStore;
+}
+
+template<typename T, size_t N>
+OrderBook<T, N> TickStoreService<T, N>::GetBookAsOf(const string& _productId, long long _time)
+{
+	return GetTickStore(_productId).GetBookAsOf(_time);
+}
+
+template<typename T, size_t N>
+long TickStoreService<T, N>::Replay(const string& _productId, long long _start, long long _end, ServiceListener<OrderBook<T, N>>* _listener)
+{
+	auto _iter = tickStores.find(_productId);
+	if (_iter == tickStores.end()) return 0;
+	return _iter->second.Replay(_start, _end, _listener);
+}
+
+/**
+* Tick Store Service Listener subscribing data from Market Data Service to Tick Store Service.
+* Type T is the product type.
+* N is the book depth.
+*/
+template<typename T, size_t N>
+class TickStoreToMarketDataListener : public ServiceListener<OrderBook<T, N>>
+{
+
+private:
+
+	TickStoreService<T, N>* service;
+
+public:
+
+	// Connector and Destructor
+	TickStoreToMarketDataListener(TickStoreService<T, N>* _service);
+	~TickStoreToMarketDataListener();
+
+	// Listener callback to process an add event to the Service
+	void ProcessAdd(OrderBook<T, N>& _data);
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(OrderBook<T, N>& _data);
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(OrderBook<T, N>& _data);
+
+};
+
+template<typename T, size_t N>
+TickStoreToMarketDataListener<T, N>::TickStoreToMarketDataListener(TickStoreService<T, N>* _service)
+{
+	service = _service;
+}
+
+template<typename T, size_t N>
+TickStoreToMarketDataListener<T, N>::~TickStoreToMarketDataListener() {}
+
+template<typename T, size_t N>
+void TickStoreToMarketDataListener<T, N>::ProcessAdd(OrderBook<T, N>& _data)
+{
+	service->OnMessage(_data);
+}
+
+template<typename T, size_t N>
+void TickStoreToMarketDataListener<T, N>::ProcessRemove(OrderBook<T, N>& _data) {}
+
+template<typename T, size_t N>
+void TickStoreToMarketDataListener<T, N>::ProcessUpdate(OrderBook<T, N>& _data) {}
+
+#endif
@@ -0,0 +1,217 @@
+/**
+* topofbooktable.hpp
+* Defines a structure-of-arrays table of top of book prices and sizes across products.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef TOP_OF_BOOK_TABLE_HPP
+#define TOP_OF_BOOK_TABLE_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+using namespace std;
+
+/**
+* Top of book table holding best bid, best offer and sizes for every product.
+* Each field is a contiguous column indexed by a product slot, so scans across
+* the whole universe run over flat arrays that the compiler can vectorize.
+* Scans work in blocks of SCAN_BLOCK slots: the predicate of a block is written
+* to a mask with no branches, then the matching slots of the block are compacted.
+* A product with no bid or no offer (price 0) has no spread and never matches.
+*/
+class TopOfBookTable
+{
+
+public:
+
+	// Number of slots whose predicate is computed before they are compacted
+	static const long SCAN_BLOCK = 64;
+
+	// ctor for a top of book table
+	TopOfBookTable() = default;
+
+	// Get the slot of a product, adding it to the table if it is new
+	long GetSlot(const string& _productId);
+
+	// Get the slot of a product, or -1 if it is not in the table
+	long FindSlot(const string& _productId) const;
+
+	// Update the top of book of a product
+	void Update(const string& _productId, double _bidPrice, long _bidQuantity, double _offerPrice, long _offerQuantity);
+
+	// Get the number of products in the table
+	long GetSize() const;
+
+	// Get the product identifier of a slot
+	const string& GetProductId(long _slot) const;
+
+	// Get the best bid price column
+	const vector<double>& GetBidPrices() const;
+
+	// Get the best offer price column
+	const vector<double>& GetOfferPrices() const;
+
+	// Get the best bid size column
+	const vector<long>& GetBidQuantities() const;
+
+	// Get the best offer size column
+	const vector<long>& GetOfferQuantities() const;
+
+	// Count products with a top of book spread at most the given spread
+	long CountSpreadAtMost(double _spread) const;
+
+	// Collect slots of products with a top of book spread at most the given spread
+	long ScanSpreadAtMost(double _spread, vector<long>& _slots) const;
+
+	// Collect slots of products with a top of book spread at least the given spread
+	long ScanSpreadAtLeast(double _spread, vector<long>& _slots) const;
+
+private:
+	unordered_map<string, long> slots;
+	vector<string> productIds;
+	vector<double> bidPrices;
+	vector<double> offerPrices;
+	vector<long> bidQuantities;
+	vector<long> offerQuantities;
+
+	// Append the slots of a block whose mask is set, and get the new count
+	static long Compact(const unsigned char* _mask, long _start, long _length, long* _out, long _count);
+
+};
+
+long TopOfBookTable::GetSlot(const string& _productId)
+{
+	auto _iter = slots.find(_productId);
+	if (_iter != slots.end()) return _iter->second;
+
+	long _slot = productIds.size();
+	slots[_productId] = _slot;
+	productIds.push_back(_productId);
+	bidPrices.push_back(0.0);
+	offerPrices.push_back(0.0);
+	bidQuantities.push_back(0);
+	offerQuantities.push_back(0);
+	return _slot;
+}
+
+long TopOfBookTable::FindSlot(const string& _productId) const
+{
+	auto _iter = slots.find(_productId);
+	return _iter != slots.end() ? _iter->second : -1;
+}
+
+void TopOfBookTable::Update(const string& _productId, double _bidPrice, long _bidQuantity, double _offerPrice, long _offerQuantity)
+{
+	long _slot = GetSlot(_productId);
+	bidPrices[_slot] = _bidPrice;
+	offerPrices[_slot] = _offerPrice;
+	bidQuantities[_slot] = _bidQuantity;
+	offerQuantities[_slot] = _offerQuantity;
+}
+
+long TopOfBookTable::GetSize() const
+{
+	return productIds.size();
+}
+
+const string& TopOfBookTable::GetProductId(long _slot) const
+{
+	return productIds[_slot];
+}
+
+const vector<double>& TopOfBookTable::GetBidPrices() const
+{
+	return bidPrices;
+}
+
+const vector<double>& TopOfBookTable::GetOfferPrices() const
+{
+	return offerPrices;
+}
+
+const vector<long>& TopOfBookTable::GetBidQuantities() const
+{
+	return bidQuantities;
+}
+
+const vector<long>& TopOfBookTable::GetOfferQuantities() const
+{
+	return offerQuantities;
+}
+
+long TopOfBookTable::CountSpreadAtMost(double _spread) const
+{
+	const double* _bids = bidPrices.data();
+	const double* _offers = offerPrices.data();
+	long _size = productIds.size();
+	long _count = 0;
+	for (long i = 0; i < _size; i++)
+	{
+		_count += (_bids[i] > 0.0) & (_offers[i] > 0.0) & (_offers[i] - _bids[i] <= _spread);
+	}
+	return _count;
+}
+
+long TopOfBookTable::ScanSpreadAtMost(double _spread, vector<long>& _slots) const
+{
+	// Size the output once; the caller can reuse it across scans.
+	const double* _bids = bidPrices.data();
+	const double* _offers = offerPrices.data();
+	long _size = productIds.size();
+	_slots.resize(_size);
+	long* _out = _slots.data();
+	long _count = 0;
+	unsigned char _mask[SCAN_BLOCK];
+	for (long _start = 0; _start < _size; _start += SCAN_BLOCK)
+	{
+		long _length = _size - _start < SCAN_BLOCK ? _size - _start : SCAN_BLOCK;
+		const double* _blockBids = _bids + _start;
+		const double* _blockOffers = _offers + _start;
+		for (long i = 0; i < _length; i++)
+		{
+			_mask[i] = (_blockBids[i] > 0.0) & (_blockOffers[i] > 0.0) & (_blockOffers[i] - _blockBids[i] <= _spread);
+		}
+		_count = Compact(_mask, _start, _length, _out, _count);
+	}
+	_slots.resize(_count);
+	return _count;
+}
+
+long TopOfBookTable::ScanSpreadAtLeast(double _spread, vector<long>& _slots) const
+{
+	const double* _bids = bidPrices.data();
+	const double* _offers = offerPrices.data();
+	long _size = productIds.size();
+	_slots.resize(_size);
+	long* _out = _slots.data();
+	long _count = 0;
+	unsigned char _mask[SCAN_BLOCK];
+	for (long _start = 0; _start < _size; _start += SCAN_BLOCK)
+	{
+		long _length = _size - _start < SCAN_BLOCK ? _size - _start : SCAN_BLOCK;
+		const double* _blockBids = _bids + _start;
+		const double* _blockOffers = _offers + _start;
+		for (long i = 0; i < _length; i++)
+		{
+			_mask[i] = (_blockBids[i] > 0.0) & (_blockOffers[i] > 0.0) & (_blockOffers[i] - _blockBids[i] >= _spread);
+		}
+		_count = Compact(_mask, _start, _length, _out, _count);
+	}
+	_slots.resize(_count);
+	return _count;
+}
+
+long TopOfBookTable::Compact(const unsigned char* _mask, long _start, long _length, long* _out, long _count)
+{
+	for (long i = 0; i < _length; i++)
+	{
+		_out[_count] = _start + i;
+		_count += _mask[i];
+	}
+	return _count;
+}
+
+#endif
@@ -12,6 +12,10 @@
 #include <vector>
 #include "soa.hpp"
 #include "executionservice.hpp"
+#include "latencytracer.hpp"
+#include "tradestore.hpp"
+#include "tradededuplicator.hpp"
+#include "tradesequencer.hpp"
 
 // Trade sides
 enum Side { BUY, SELL };
@@ -116,6 +120,10 @@ class TradeBookingToExecutionListener;
 
 /**
 * Trade Booking Service to book trades to a particular book.
+* Trades are kept in an indexed store that answers queries by product, book and
+* booking time without scanning every trade. Given a de-duplicator, a trade whose
+* identifier was already booked within its window is dropped before it is stored
+* or published, so a feed redelivering trades does not book them twice.
 * Keyed on trade identifier.
 * Type T is the product type.
 */
@@ -125,10 +133,11 @@ class TradeBookingService : public Service<string, Trade<T>>
 
 private:
 
-	map<string, Trade<T>> trades;
+	TradeStore<T> trades;
 	vector<ServiceListener<Trade<T>>*> listeners;
 	TradeBookingConnector<T>* connector;
 	TradeBookingToExecutionListener<T>* listener;
+	TradeDeduplicator* tradeDeduplicator;
 
 public:
 
@@ -154,18 +163,31 @@ public:
 	// Get the listener of the service
 	TradeBookingToExecutionListener<T>* GetListener();
 
-	// Book the trade
+	// Book a trade from an execution, storing and publishing it once unless it is a duplicate
 	void BookTrade(Trade<T>& _trade);
 
+	// Store and publish a trade unless it is a duplicate, and get whether it was new
+	bool AddTrade(Trade<T>& _trade);
+
+	// Set the de-duplicator of the trades
+	void SetTradeDeduplicator(TradeDeduplicator* _tradeDeduplicator);
+
+	// Get the store of the trades
+	const TradeStore<T>& GetTradeStore() const;
+
+	// Get the trades booked in a time range in microseconds, narrowed to a product and a book when they are not empty
+	void GetTrades(const string& _productId, const string& _book, long long _from, long long _to, vector<const Trade<T>*>& _trades) const;
+
 };
 
 template<typename T>
 TradeBookingService<T>::TradeBookingService()
 {
-	trades = map<string, Trade<T>>();
+	trades = TradeStore<T>();
 	listeners = vector<ServiceListener<Trade<T>>*>();
 	connector = new TradeBookingConnector<T>(this);
 	listener = new TradeBookingToExecutionListener<T>(this);
+	tradeDeduplicator = nullptr;
 }
 
 template<typename T>
@@ -174,18 +196,39 @@ TradeBookingService<T>::~TradeBookingService() {}
 template<typename T>
 Trade<T>& TradeBookingService<T>::GetData(string _key)
 {
-	return trades[_key];
+	Trade<T>* _trade = trades.FindTrade(_key);
+	if (_trade) return *_trade;
+
+	// Unknown ids get an empty trade rather than a record in the store.
+	static Trade<T> _emptyTrade;
+	_emptyTrade = Trade<T>();
+	return _emptyTrade;
 }
 
 template<typename T>
 void TradeBookingService<T>::OnMessage(Trade<T>& _data)
 {
-	trades[_data.GetTradeId()] = _data;
+	AddTrade(_data);
+}
+
+template<typename T>
+bool TradeBookingService<T>::AddTrade(Trade<T>& _trade)
+{
+	long long _time = GetEpochMicrosecond();
+	if (tradeDeduplicator && tradeDeduplicator->IsDuplicate(_trade.GetTradeId(), _time)) return false;
+	trades.AddTrade(_trade, _time);
 
 	for (auto& l : listeners)
 	{
-		l->ProcessAdd(_data);
+		l->ProcessAdd(_trade);
 	}
+	return true;
+}
+
+template<typename T>
+void TradeBookingService<T>::SetTradeDeduplicator(TradeDeduplicator* _tradeDeduplicator)
+{
+	tradeDeduplicator = _tradeDeduplicator;
 }
 
 template<typename T>
@@ -215,10 +258,19 @@ TradeBookingToExecutionListener<T>* TradeBookingService<T>::GetListener()
 template<typename T>
 void TradeBookingService<T>::BookTrade(Trade<T>& _trade)
 {
-	for (auto& l : listeners)
-	{
-		l->ProcessAdd(_trade);
-	}
+	if (AddTrade(_trade)) TRACE_STAGE(TRADE_BOOKED);
+}
+
+template<typename T>
+const TradeStore<T>& TradeBookingService<T>::GetTradeStore() const
+{
+	return trades;
+}
+
+template<typename T>
+void TradeBookingService<T>::GetTrades(const string& _productId, const string& _book, long long _from, long long _to, vector<const Trade<T>*>& _trades) const
+{
+	trades.Query(_productId, _book, _from, _to, _trades);
 }
 
 /**
@@ -232,6 +284,10 @@ class TradeBookingConnector : public Connector<Trade<T>>
 private:
 
 	TradeBookingService<T>* service;
+	TradeSequencer<T>* tradeSequencer;
+	long tradeCount;
+	long skipCount;
+	bool subscribing;
 
 public:
 
@@ -245,12 +301,31 @@ public:
 	// Subscribe data from the Connector
 	void Subscribe(ifstream& _data);
 
+	// Get the number of trades read
+	long GetTradeCount() const;
+
+	// Is the connector reading trades?
+	bool IsSubscribing() const;
+
+	// Is every trade read booked or dropped, with none waiting in the sequencer?
+	bool IsSettled() const;
+
+	// Skip the trades already read before a restart
+	void SkipTrades(long _skipCount);
+
+	// Set the sequencer of trades carrying a source and a sequence
+	void SetTradeSequencer(TradeSequencer<T>* _tradeSequencer);
+
 };
 
 template<typename T>
 TradeBookingConnector<T>::TradeBookingConnector(TradeBookingService<T>* _service)
 {
 	service = _service;
+	tradeSequencer = nullptr;
+	tradeCount = 0;
+	skipCount = 0;
+	subscribing = false;
 }
 
 template<typename T>
@@ -262,9 +337,13 @@ void TradeBookingConnector<T>::Publish(Trade<T>& _data) {}
 template<typename T>
 void TradeBookingConnector<T>::Subscribe(ifstream& _data)
 {
+	subscribing = true;
 	string _line;
 	while (getline(_data, _line))
 	{
+		// Trades already in a loaded checkpoint are passed over without being parsed.
+		if (++tradeCount <= skipCount) continue;
+
 		stringstream _lineStream(_line);
 		string _cell;
 		vector<string> _cells;
@@ -280,11 +359,54 @@ void TradeBookingConnector<T>::Subscribe(ifstream& _data)
 		long _quantity = stol(_cells[4]);
 		Side _side;
 		if (_cells[5] == "BUY") _side = BUY;
-		else if (_cells[5] == "SELL") _side = SELL;
+		else _side = SELL;
 		T _product = GetBond(_productId);
 		Trade<T> _trade(_product, _tradeId, _price, _book, _quantity, _side);
+
+		// A sequenced line also names its source and sequence, and the sequencer puts it in order.
+		if (tradeSequencer && _cells.size() >= 8)
+		{
+			long long _time = GetEpochMicrosecond();
+			tradeSequencer->OnTrade(_cells[6], stoll(_cells[7]), _trade, _time);
+			tradeSequencer->OnTimer(_time);
+			continue;
+		}
 		service->OnMessage(_trade);
 	}
+
+	// No gap can close once the file is read, so the trades still waiting on one are released.
+	if (tradeSequencer) tradeSequencer->Flush();
+	subscribing = false;
+}
+
+template<typename T>
+long TradeBookingConnector<T>::GetTradeCount() const
+{
+	return tradeCount;
+}
+
+template<typename T>
+bool TradeBookingConnector<T>::IsSubscribing() const
+{
+	return subscribing;
+}
+
+template<typename T>
+bool TradeBookingConnector<T>::IsSettled() const
+{
+	return !tradeSequencer || tradeSequencer->GetWaitingCount() == 0;
+}
+
+template<typename T>
+void TradeBookingConnector<T>::SkipTrades(long _skipCount)
+{
+	skipCount = _skipCount;
+}
+
+template<typename T>
+void TradeBookingConnector<T>::SetTradeSequencer(TradeSequencer<T>* _tradeSequencer)
+{
+	tradeSequencer = _tradeSequencer;
 }
 
 /**
@@ -345,6 +467,7 @@ void TradeBookingToExecutionListener<T>::ProcessAdd(ExecutionOrder<T>& _data)
 		_side = SELL;
 		break;
 	case OFFER:
+	default:
 		_side = BUY;
 		break;
 	}
@@ -363,8 +486,10 @@ void TradeBookingToExecutionListener<T>::ProcessAdd(ExecutionOrder<T>& _data)
 	}
 	long _quantity = _visibleQuantity + _hiddenQuantity;
 
-	Trade<T> _trade(_product, _orderId, _price, _book, _quantity, _side);
-	service->OnMessage(_trade);
+	// Partial fills and the shares of a routed order all come under one order ID,
+	// so each fill is booked under its own trade ID for the de-duplicator to keep it.
+	string _tradeId = _orderId + "-" + to_string(count);
+	Trade<T> _trade(_product, _tradeId, _price, _book, _quantity, _side);
 	service->BookTrade(_trade);
 }
 
@@ -0,0 +1,185 @@
+/**
+* tradebulkloader.hpp
+* Defines the bulk loader of start of day trade files into positions.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef TRADE_BULK_LOADER_HPP
+#define TRADE_BULK_LOADER_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include "positionservice.hpp"
+
+using namespace std;
+
+/**
+* Bulk loader of a start of day trade file into Position Service.
+* The file is read in one go and cut into chunks at line boundaries, one for
+* each thread. Each thread parses its own chunk into positions by product and
+* book, and the per-thread positions are then added together. Only then does each
+* product go to the service, as a single position event carrying all its books, so
+* listeners such as risk and the historical data service do work in the number of
+* products rather than the number of trades. Prices and trade identifiers play no
+* part in positions and are not parsed.
+* Type T is the product type.
+*/
+template<typename T>
+class TradeBulkLoader
+{
+
+public:
+
+	// ctor for a bulk loader into a position service
+	TradeBulkLoader(PositionService<T>* _positionService);
+
+	// Load a trade file, in parallel on every core when no thread count is given, and get the number of trades loaded
+	long Load(ifstream& _data, unsigned int _threads = 0);
+
+	// Get the number of lines that could not be parsed in the last load
+	long GetRejectedCount() const;
+
+private:
+
+	typedef unordered_map<string, map<string, long>> ProductPositions;
+
+	PositionService<T>* positionService;
+	long rejectedCount;
+
+	// Parse the lines in a range of text into positions, and get the number of trades parsed
+	static long ParseChunk(const char* _begin, const char* _end, ProductPositions& _positions, long& _rejected);
+
+};
+
+template<typename T>
+TradeBulkLoader<T>::TradeBulkLoader(PositionService<T>* _positionService)
+{
+	positionService = _positionService;
+	rejectedCount = 0;
+}
+
+template<typename T>
+long TradeBulkLoader<T>::GetRejectedCount() const
+{
+	return rejectedCount;
+}
+
+template<typename T>
+long TradeBulkLoader<T>::ParseChunk(const char* _begin, const char* _end, ProductPositions& _positions, long& _rejected)
+{
+	long _count = 0;
+	string _productId;
+	string _book;
+	const char* _line = _begin;
+	while (_line < _end)
+	{
+		const char* _lineEnd = (const char*)memchr(_line, '\n', _end - _line);
+		if (!_lineEnd) _lineEnd = _end;
+
+		// Fields are product, trade identifier, price, book, quantity and side.
+		const char* _fields[6];
+		const char* _fieldEnds[6];
+		int _fieldCount = 0;
+		const char* _field = _line;
+		while (_fieldCount < 6)
+		{
+			const char* _comma = (const char*)memchr(_field, ',', _lineEnd - _field);
+			_fields[_fieldCount] = _field;
+			_fieldEnds[_fieldCount] = _comma ? _comma : _lineEnd;
+			_fieldCount++;
+			if (!_comma) break;
+			_field = _comma + 1;
+		}
+		if (_fieldCount == 6)
+		{
+			const char* _sideEnd = _fieldEnds[5];
+			while (_sideEnd > _fields[5] && (_sideEnd[-1] == '\r' || _sideEnd[-1] == ' ')) _sideEnd--;
+			size_t _sideLength = _sideEnd - _fields[5];
+			bool _isBuy = _sideLength == 3 && memcmp(_fields[5], "BUY", 3) == 0;
+			bool _isSell = _sideLength == 4 && memcmp(_fields[5], "SELL", 4) == 0;
+			char* _quantityEnd;
+			long _quantity = strtol(_fields[4], &_quantityEnd, 10);
+			if ((_isBuy || _isSell) && _quantityEnd == _fieldEnds[4])
+			{
+				_productId.assign(_fields[0], _fieldEnds[0]);
+				_book.assign(_fields[3], _fieldEnds[3]);
+				_positions[_productId][_book] += _isBuy ? _quantity : -_quantity;
+				_count++;
+			}
+			else
+			{
+				_rejected++;
+			}
+		}
+		else if (_lineEnd > _line && !(_lineEnd - _line == 1 && *_line == '\r'))
+		{
+			_rejected++;
+		}
+		_line = _lineEnd + 1;
+	}
+	return _count;
+}
+
+template<typename T>
+long TradeBulkLoader<T>::Load(ifstream& _data, unsigned int _threads)
+{
+	stringstream _buffer;
+	_buffer << _data.rdbuf();
+	string _text = _buffer.str();
+	const char* _begin = _text.data();
+	const char* _end = _begin + _text.size();
+
+	if (_threads == 0) _threads = max(1u, thread::hardware_concurrency());
+	if (_text.size() < (size_t)_threads * 4096) _threads = 1;
+
+	// Chunks end just after a line break, so no line is split between threads.
+	vector<const char*> _bounds;
+	_bounds.push_back(_begin);
+	for (unsigned int i = 1; i < _threads; i++)
+	{
+		const char* _bound = max(_bounds.back(), _begin + _text.size() * i / _threads);
+		const char* _lineEnd = (const char*)memchr(_bound, '\n', _end - _bound);
+		_bounds.push_back(_lineEnd ? _lineEnd + 1 : _end);
+	}
+	_bounds.push_back(_end);
+
+	vector<ProductPositions> _positions(_threads);
+	vector<long> _counts(_threads, 0);
+	vector<long> _rejected(_threads, 0);
+	vector<thread> _workers;
+	for (unsigned int i = 1; i < _threads; i++)
+	{
+		_workers.push_back(thread([&, i]() { _counts[i] = ParseChunk(_bounds[i], _bounds[i + 1], _positions[i], _rejected[i]); }));
+	}
+	_counts[0] = ParseChunk(_bounds[0], _bounds[1], _positions[0], _rejected[0]);
+	for (auto& w : _workers) w.join();
+
+	long _count = _counts[0];
+	rejectedCount = _rejected[0];
+	for (unsigned int i = 1; i < _threads; i++)
+	{
+		_count += _counts[i];
+		rejectedCount += _rejected[i];
+		for (auto& p : _positions[i])
+		{
+			map<string, long>& _books = _positions[0][p.first];
+			for (auto& b : p.second) _books[b.first] += b.second;
+		}
+	}
+
+	for (auto& p : _positions[0])
+	{
+		positionService->AddPositions(GetBond(p.first), p.second);
+	}
+	return _count;
+}
+
+#endif
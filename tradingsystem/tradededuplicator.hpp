@@ -0,0 +1,221 @@
+/**
+* tradededuplicator.hpp
+* Defines the de-duplication stage of trades redelivered by a trade feed.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef TRADE_DEDUPLICATOR_HPP
+#define TRADE_DEDUPLICATOR_HPP
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+/**
+* De-duplicator of trade identifiers seen within a time window.
+* Identifiers are kept as 64-bit hashes in an open addressing table with linear
+* probing, sized to twice the capacity so probes stay short, and in a ring in the
+* order they were seen. Hashes older than the window are evicted from the front of
+* the ring as time moves on, and when the ring is full the oldest hash goes early,
+* so memory is fixed by the capacity whatever the trade rate. Two hashes of distinct
+* identifiers colliding is taken as negligible at 64 bits.
+* With the Bloom filter on, a new identifier, the common case, is usually told
+* apart by a few bits in a small filter without probing the table. The filter has
+* two generations, each started a window apart, so every identifier seen within
+* the window is in one of them and the older generation can simply be cleared.
+*/
+class TradeDeduplicator
+{
+
+public:
+
+	// ctor for a de-duplicator of up to a capacity of identifiers seen within a window
+	TradeDeduplicator(long _capacity, long long _window, bool _useBloomFilter);
+
+	// Check whether an identifier was seen within the window before a time, and record it
+	bool IsDuplicate(const string& _tradeId, long long _time);
+
+	// Get the number of duplicates found
+	long GetDuplicateCount() const;
+
+	// Get the number of identifiers evicted before their window ended
+	long GetEarlyEvictionCount() const;
+
+	// Get the number of identifiers held
+	long GetSize() const;
+
+private:
+
+	vector<unsigned long long> table;
+	unsigned long long tableMask;
+	vector<unsigned long long> ringHashes;
+	vector<long long> ringTimes;
+	long ringHead;
+	long ringSize;
+	long long window;
+	bool useBloomFilter;
+	vector<unsigned long long> bloomFilters[2];
+	unsigned long long bloomMask;
+	int bloomCurrent;
+	long long bloomStart;
+	long duplicateCount;
+	long earlyEvictionCount;
+
+	// Hash an identifier, never to zero which marks an empty slot
+	static unsigned long long Hash(const char* _tradeId, size_t _length);
+
+	// Find the slot of a hash, or the empty slot where it would go
+	unsigned long long FindSlot(unsigned long long _hash) const;
+
+	// Remove a hash from the table
+	void Remove(unsigned long long _hash);
+
+	// Evict the oldest hash in the ring
+	void EvictOldest();
+
+	// Check whether a hash may be in the Bloom filter, and add it to the current generation
+	bool TestAndSetBloom(unsigned long long _hash, long long _time);
+
+};
+
+TradeDeduplicator::TradeDeduplicator(long _capacity, long long _window, bool _useBloomFilter)
+{
+	unsigned long long _tableSize = 16;
+	while (_tableSize < 2 * (unsigned long long)_capacity) _tableSize *= 2;
+	table = vector<unsigned long long>(_tableSize, 0);
+	tableMask = _tableSize - 1;
+	ringHashes = vector<unsigned long long>(_capacity, 0);
+	ringTimes = vector<long long>(_capacity, 0);
+	ringHead = 0;
+	ringSize = 0;
+	window = _window;
+	useBloomFilter = _useBloomFilter;
+
+	// About 16 bits an identifier in each generation keeps false positives near 1% at 3 bits a word.
+	unsigned long long _bloomWords = useBloomFilter ? _tableSize / 8 : 0;
+	bloomFilters[0] = vector<unsigned long long>(_bloomWords, 0);
+	bloomFilters[1] = vector<unsigned long long>(_bloomWords, 0);
+	bloomMask = _bloomWords - 1;
+	bloomCurrent = 0;
+	bloomStart = 0;
+	duplicateCount = 0;
+	earlyEvictionCount = 0;
+}
+
+unsigned long long TradeDeduplicator::Hash(const char* _tradeId, size_t _length)
+{
+	unsigned long long _hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < _length; i++)
+	{
+		_hash ^= (unsigned char)_tradeId[i];
+		_hash *= 1099511628211ULL;
+	}
+	return _hash ? _hash : 1;
+}
+
+unsigned long long TradeDeduplicator::FindSlot(unsigned long long _hash) const
+{
+	unsigned long long _slot = _hash & tableMask;
+	while (table[_slot] != 0 && table[_slot] != _hash)
+	{
+		_slot = (_slot + 1) & tableMask;
+	}
+	return _slot;
+}
+
+void TradeDeduplicator::Remove(unsigned long long _hash)
+{
+	unsigned long long _slot = FindSlot(_hash);
+	if (table[_slot] == 0) return;
+
+	// Shift later entries of the cluster back so no probe sequence is broken.
+	unsigned long long _next = _slot;
+	while (true)
+	{
+		_next = (_next + 1) & tableMask;
+		if (table[_next] == 0) break;
+		unsigned long long _home = table[_next] & tableMask;
+		if (((_next - _home) & tableMask) >= ((_next - _slot) & tableMask))
+		{
+			table[_slot] = table[_next];
+			_slot = _next;
+		}
+	}
+	table[_slot] = 0;
+}
+
+void TradeDeduplicator::EvictOldest()
+{
+	Remove(ringHashes[ringHead]);
+	ringHead = (ringHead + 1) % ringHashes.size();
+	ringSize--;
+}
+
+bool TradeDeduplicator::TestAndSetBloom(unsigned long long _hash, long long _time)
+{
+	if (_time - bloomStart >= window)
+	{
+		bloomCurrent ^= 1;
+		fill(bloomFilters[bloomCurrent].begin(), bloomFilters[bloomCurrent].end(), 0);
+		bloomStart = _time;
+	}
+
+	// The three bits of a hash sit in one word, so each generation costs a single load.
+	unsigned long long _word = (_hash >> 18) & bloomMask;
+	unsigned long long _mask = (1ULL << (_hash & 63)) | (1ULL << ((_hash >> 6) & 63)) | (1ULL << ((_hash >> 12) & 63));
+	bool _maybe = (bloomFilters[bloomCurrent][_word] & _mask) == _mask;
+	bool _maybeOlder = (bloomFilters[bloomCurrent ^ 1][_word] & _mask) == _mask;
+	bloomFilters[bloomCurrent][_word] |= _mask;
+	return _maybe || _maybeOlder;
+}
+
+bool TradeDeduplicator::IsDuplicate(const string& _tradeId, long long _time)
+{
+	while (ringSize > 0 && _time - ringTimes[ringHead] > window)
+	{
+		EvictOldest();
+	}
+
+	unsigned long long _hash = Hash(_tradeId.data(), _tradeId.size());
+	if (!useBloomFilter || TestAndSetBloom(_hash, _time))
+	{
+		unsigned long long _slot = FindSlot(_hash);
+		if (table[_slot] != 0)
+		{
+			duplicateCount++;
+			return true;
+		}
+	}
+
+	if (ringSize == (long)ringHashes.size())
+	{
+		EvictOldest();
+		earlyEvictionCount++;
+	}
+	table[FindSlot(_hash)] = _hash;
+	long _tail = (ringHead + ringSize) % ringHashes.size();
+	ringHashes[_tail] = _hash;
+	ringTimes[_tail] = _time;
+	ringSize++;
+	return false;
+}
+
+long TradeDeduplicator::GetDuplicateCount() const
+{
+	return duplicateCount;
+}
+
+long TradeDeduplicator::GetEarlyEvictionCount() const
+{
+	return earlyEvictionCount;
+}
+
+long TradeDeduplicator::GetSize() const
+{
+	return ringSize;
+}
+
+#endif
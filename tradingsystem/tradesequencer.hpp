@@ -0,0 +1,276 @@
+/**
+* tradesequencer.hpp
+* Defines the sequencer putting trades of several sources back in order.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef TRADE_SEQUENCER_HPP
+#define TRADE_SEQUENCER_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+using namespace std;
+
+/**
+* Pre-declearations to avoid errors.
+*/
+template<typename T>
+class Trade;
+template<typename T>
+class TradeBookingService;
+
+/**
+* Sequencer releasing the trades of each source to Trade Booking Service in sequence order.
+* A trade carrying the next sequence of its source goes straight to the service,
+* without being copied. A trade ahead of it waits in a ring of the source indexed
+* by sequence, and is released once the trades before it arrive. A gap that stays
+* open past the timeout is given up at the next timer tick: the missing sequences
+* are counted as lost and the waiting trades go on in order. A trade too far ahead
+* for the ring gives up the oldest gaps to make room, so the ring never grows.
+* Trades with a sequence already passed are late and dropped.
+* Timer ticks only come with trades from the connector, which flushes at the end of
+* its file. A live feed needs the caller to tick OnTimer as well, or a gap left open
+* when trades go quiet holds back the trades behind it.
+* Type T is the product type.
+*/
+template<typename T>
+class TradeSequencer
+{
+
+public:
+
+	// ctor for a sequencer with a ring of a capacity for each source and a gap timeout in microseconds
+	TradeSequencer(TradeBookingService<T>* _service, long _capacity, long long _gapTimeout);
+
+	// Take a trade of a source with its sequence at a time
+	void OnTrade(const string& _source, long long _sequence, Trade<T>& _trade, long long _time);
+
+	// Give up every gap open past the timeout at a time
+	void OnTimer(long long _time);
+
+	// Give up every open gap, releasing all waiting trades
+	void Flush();
+
+	// Get the next sequence expected from a source
+	long long GetNextSequence(const string& _source) const;
+
+	// Get the number of trades of a source waiting for a gap to close
+	long GetWaitingCount(const string& _source) const;
+
+	// Get the number of trades of all sources waiting for a gap to close
+	long GetWaitingCount() const;
+
+	// Get the number of sequences of a source given up as lost
+	long GetLostCount(const string& _source) const;
+
+	// Get the number of trades of a source dropped as late
+	long GetLateCount(const string& _source) const;
+
+private:
+
+	struct SourceState
+	{
+		long long nextSequence;
+		vector<Trade<T>> trades;
+		vector<long long> sequences;
+		long waitingCount;
+		long long gapTime;
+		long lostCount;
+		long lateCount;
+	};
+
+	TradeBookingService<T>* service;
+	unordered_map<string, SourceState> sources;
+	long waitingCount;
+	long long mask;
+	long long gapTimeout;
+
+	// Get the state of a source, adding it if it is new
+	SourceState& FindSource(const string& _source);
+
+	// Release the waiting trades that follow on from the next sequence
+	void Release(SourceState& _state, long long _time);
+
+	// Give up the gap before the first waiting trade, or up to a sequence
+	void Skip(SourceState& _state, long long _sequence);
+
+};
+
+template<typename T>
+TradeSequencer<T>::TradeSequencer(TradeBookingService<T>* _service, long _capacity, long long _gapTimeout)
+{
+	service = _service;
+	sources = unordered_map<string, SourceState>();
+	waitingCount = 0;
+	long long _size = 2;
+	while (_size < _capacity) _size *= 2;
+	mask = _size - 1;
+	gapTimeout = _gapTimeout;
+}
+
+template<typename T>
+typename TradeSequencer<T>::SourceState& TradeSequencer<T>::FindSource(const string& _source)
+{
+	auto _iter = sources.find(_source);
+	if (_iter == sources.end())
+	{
+		SourceState _state;
+		_state.nextSequence = 1;
+		_state.trades = vector<Trade<T>>(mask + 1);
+		_state.sequences = vector<long long>(mask + 1, -1);
+		_state.waitingCount = 0;
+		_state.gapTime = 0;
+		_state.lostCount = 0;
+		_state.lateCount = 0;
+		_iter = sources.insert(make_pair(_source, _state)).first;
+	}
+	return _iter->second;
+}
+
+template<typename T>
+void TradeSequencer<T>::OnTrade(const string& _source, long long _sequence, Trade<T>& _trade, long long _time)
+{
+	SourceState& _state = FindSource(_source);
+	if (_sequence == _state.nextSequence)
+	{
+		_state.nextSequence++;
+		service->OnMessage(_trade);
+		if (_state.waitingCount > 0) Release(_state, _time);
+		return;
+	}
+	if (_sequence < _state.nextSequence || _state.sequences[_sequence & mask] == _sequence)
+	{
+		_state.lateCount++;
+		return;
+	}
+
+	// Too far ahead for the ring, so the oldest gaps are given up to make room.
+	if (_sequence - _state.nextSequence > mask)
+	{
+		Skip(_state, _sequence - mask);
+		Release(_state, _time);
+		if (_sequence == _state.nextSequence)
+		{
+			OnTrade(_source, _sequence, _trade, _time);
+			return;
+		}
+	}
+
+	long long _slot = _sequence & mask;
+	_state.trades[_slot] = _trade;
+	_state.sequences[_slot] = _sequence;
+	waitingCount++;
+	if (_state.waitingCount++ == 0) _state.gapTime = _time;
+}
+
+template<typename T>
+void TradeSequencer<T>::Release(SourceState& _state, long long _time)
+{
+	while (_state.waitingCount > 0)
+	{
+		long long _slot = _state.nextSequence & mask;
+		if (_state.sequences[_slot] != _state.nextSequence) break;
+		_state.sequences[_slot] = -1;
+		_state.waitingCount--;
+		waitingCount--;
+		_state.nextSequence++;
+		service->OnMessage(_state.trades[_slot]);
+	}
+
+	// Trades still waiting sit behind a new gap, timed from now.
+	if (_state.waitingCount > 0) _state.gapTime = _time;
+}
+
+template<typename T>
+void TradeSequencer<T>::Skip(SourceState& _state, long long _sequence)
+{
+	if (_sequence < 0)
+	{
+		// Without a bound, the gap runs up to the first waiting trade.
+		_sequence = _state.nextSequence;
+		while (_state.sequences[_sequence & mask] != _sequence) _sequence++;
+	}
+	while (_state.nextSequence < _sequence)
+	{
+		long long _slot = _state.nextSequence & mask;
+		if (_state.sequences[_slot] == _state.nextSequence)
+		{
+			_state.sequences[_slot] = -1;
+			_state.waitingCount--;
+			waitingCount--;
+			service->OnMessage(_state.trades[_slot]);
+		}
+		else
+		{
+			_state.lostCount++;
+		}
+		_state.nextSequence++;
+	}
+}
+
+template<typename T>
+void TradeSequencer<T>::OnTimer(long long _time)
+{
+	for (auto& s : sources)
+	{
+		SourceState& _state = s.second;
+		if (_state.waitingCount > 0 && _time - _state.gapTime >= gapTimeout)
+		{
+			Skip(_state, -1);
+			Release(_state, _time);
+		}
+	}
+}
+
+template<typename T>
+void TradeSequencer<T>::Flush()
+{
+	for (auto& s : sources)
+	{
+		SourceState& _state = s.second;
+		while (_state.waitingCount > 0)
+		{
+			Skip(_state, -1);
+			Release(_state, _state.gapTime);
+		}
+	}
+}
+
+template<typename T>
+long long TradeSequencer<T>::GetNextSequence(const string& _source) const
+{
+	auto _iter = sources.find(_source);
+	return _iter == sources.end() ? 1 : _iter->second.nextSequence;
+}
+
+template<typename T>
+long TradeSequencer<T>::GetWaitingCount(const string& _source) const
+{
+	auto _iter = sources.find(_source);
+	return _iter == sources.end() ? 0 : _iter->second.waitingCount;
+}
+
+template<typename T>
+long TradeSequencer<T>::GetWaitingCount() const
+{
+	return waitingCount;
+}
+
+template<typename T>
+long TradeSequencer<T>::GetLostCount(const string& _source) const
+{
+	auto _iter = sources.find(_source);
+	return _iter == sources.end() ? 0 : _iter->second.lostCount;
+}
+
+template<typename T>
+long TradeSequencer<T>::GetLateCount(const string& _source) const
+{
+	auto _iter = sources.find(_source);
+	return _iter == sources.end() ? 0 : _iter->second.lateCount;
+}
+
+#endif
@@ -0,0 +1,242 @@
+/**
+* tradestore.hpp
+* Defines the indexed append-only store of booked trades.
+*
+* @author Breman Thuraisingham
+* @coauthor Junliang Jimmy Zhou
+*/
+#ifndef TRADE_STORE_HPP
+#define TRADE_STORE_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <unordered_map>
+#include "positionmatrix.hpp"
+
+using namespace std;
+
+/**
+* Pre-declearations to avoid errors.
+*/
+template<typename T>
+class Trade;
+
+/**
+* Append-only store of trades indexed by id, product, book and booking time.
+* Trades live in a deque, so a trade never moves once stored and queries hand out
+* pointers to it instead of copies. Every record is stamped with its booking time,
+* clamped so that records are in time order, which makes the record sequence itself
+* the time index. Each product and each book keeps the records booked to it in
+* the same order, so a query narrows to the shorter of the two lists, finds its
+* start by binary search on time and walks forward until the end of the range.
+* Booking a trade again under a known id appends a new record that supersedes the
+* old one, and queries only see the latest record of each id.
+* Type T is the product type.
+*/
+template<typename T>
+class TradeStore
+{
+
+public:
+
+	// ctor for an empty store
+	TradeStore();
+
+	// Add a trade booked at a time in microseconds, and get its record
+	long AddTrade(const Trade<T>& _trade, long long _bookingTime);
+
+	// Get the trade of an id, or nullptr if it is unknown
+	const Trade<T>* FindTrade(const string& _tradeId) const;
+	Trade<T>* FindTrade(const string& _tradeId);
+
+	// Get the trade of a record
+	const Trade<T>& GetTrade(long _record) const;
+
+	// Get the booking time of a record
+	long long GetBookingTime(long _record) const;
+
+	// Get the number of records
+	long GetRecordCount() const;
+
+	// Get the latest trades booked in a time range, narrowed to a product and a book when they are not empty
+	void Query(const string& _productId, const string& _book, long long _from, long long _to, vector<const Trade<T>*>& _trades) const;
+
+	// Get the number of the latest trades a query would return
+	long Count(const string& _productId, const string& _book, long long _from, long long _to) const;
+
+private:
+
+	struct TradeRecord
+	{
+		long long bookingTime;
+		long productSlot;
+		long bookId;
+		bool current;
+	};
+
+	deque<Trade<T>> trades;
+	vector<TradeRecord> records;
+	unordered_map<string, long> tradeIds;
+	unordered_map<string, long> productIds;
+	BookRegistry books;
+	vector<vector<long>> productRecords;
+	vector<vector<long>> bookRecords;
+
+	// Visit the latest records of a query in time order
+	template<typename F>
+	void Visit(const string& _productId, const string& _book, long long _from, long long _to, F _visitor) const;
+
+};
+
+template<typename T>
+TradeStore<T>::TradeStore()
+{
+	trades = deque<Trade<T>>();
+	records = vector<TradeRecord>();
+	tradeIds = unordered_map<string, long>();
+	productIds = unordered_map<string, long>();
+	productRecords = vector<vector<long>>();
+	bookRecords = vector<vector<long>>();
+}
+
+template<typename T>
+long TradeStore<T>::AddTrade(const Trade<T>& _trade, long long _bookingTime)
+{
+	long _record = records.size();
+	if (_record > 0 && _bookingTime < records.back().bookingTime) _bookingTime = records.back().bookingTime;
+
+	auto _productIter = productIds.find(_trade.GetProduct().GetProductId());
+	if (_productIter == productIds.end())
+	{
+		_productIter = productIds.insert(make_pair(_trade.GetProduct().GetProductId(), (long)productRecords.size())).first;
+		productRecords.push_back(vector<long>());
+	}
+	long _bookId = books.AddBook(_trade.GetBook());
+	if (_bookId >= (long)bookRecords.size()) bookRecords.resize(_bookId + 1);
+
+	auto _idIter = tradeIds.find(_trade.GetTradeId());
+	if (_idIter == tradeIds.end())
+	{
+		tradeIds.insert(make_pair(_trade.GetTradeId(), _record));
+	}
+	else
+	{
+		records[_idIter->second].current = false;
+		_idIter->second = _record;
+	}
+
+	trades.push_back(_trade);
+	records.push_back(TradeRecord{ _bookingTime, _productIter->second, _bookId, true });
+	productRecords[_productIter->second].push_back(_record);
+	bookRecords[_bookId].push_back(_record);
+	return _record;
+}
+
+template<typename T>
+const Trade<T>* TradeStore<T>::FindTrade(const string& _tradeId) const
+{
+	auto _iter = tradeIds.find(_tradeId);
+	return _iter == tradeIds.end() ? nullptr : &trades[_iter->second];
+}
+
+template<typename T>
+Trade<T>* TradeStore<T>::FindTrade(const string& _tradeId)
+{
+	auto _iter = tradeIds.find(_tradeId);
+	return _iter == tradeIds.end() ? nullptr : &trades[_iter->second];
+}
+
+template<typename T>
+const Trade<T>& TradeStore<T>::GetTrade(long _record) const
+{
+	return trades[_record];
+}
+
+template<typename T>
+long long TradeStore<T>::GetBookingTime(long _record) const
+{
+	return records[_record].bookingTime;
+}
+
+template<typename T>
+long TradeStore<T>::GetRecordCount() const
+{
+	return records.size();
+}
+
+template<typename T>
+template<typename F>
+void TradeStore<T>::Visit(const string& _productId, const string& _book, long long _from, long long _to, F _visitor) const
+{
+	long _productSlot = -1;
+	if (!_productId.empty())
+	{
+		auto _iter = productIds.find(_productId);
+		if (_iter == productIds.end()) return;
+		_productSlot = _iter->second;
+	}
+	long _bookId = -1;
+	if (!_book.empty())
+	{
+		_bookId = books.FindBook(_book);
+		if (_bookId < 0) return;
+	}
+
+	auto _before = [this](long _record, long long _time) { return records[_record].bookingTime < _time; };
+	if (_productSlot < 0 && _bookId < 0)
+	{
+		// Records are in time order, so the whole store is searched by time directly.
+		long _record = 0;
+		long _count = records.size();
+		while (_count > 0)
+		{
+			long _step = _count / 2;
+			if (_before(_record + _step, _from))
+			{
+				_record += _step + 1;
+				_count -= _step + 1;
+			}
+			else
+			{
+				_count = _step;
+			}
+		}
+		for (; _record < (long)records.size() && records[_record].bookingTime <= _to; _record++)
+		{
+			if (records[_record].current) _visitor(_record);
+		}
+		return;
+	}
+
+	const vector<long>* _candidates = _productSlot >= 0 ? &productRecords[_productSlot] : &bookRecords[_bookId];
+	if (_productSlot >= 0 && _bookId >= 0 && bookRecords[_bookId].size() < _candidates->size()) _candidates = &bookRecords[_bookId];
+
+	for (auto _iter = lower_bound(_candidates->begin(), _candidates->end(), _from, _before); _iter != _candidates->end(); ++_iter)
+	{
+		const TradeRecord& _record = records[*_iter];
+		if (_record.bookingTime > _to) break;
+		if (!_record.current) continue;
+		if (_productSlot >= 0 && _record.productSlot != _productSlot) continue;
+		if (_bookId >= 0 && _record.bookId != _bookId) continue;
+		_visitor(*_iter);
+	}
+}
+
+template<typename T>
+void TradeStore<T>::Query(const string& _productId, const string& _book, long long _from, long long _to, vector<const Trade<T>*>& _trades) const
+{
+	_trades.clear();
+	Visit(_productId, _book, _from, _to, [this, &_trades](long _record) { _trades.push_back(&trades[_record]); });
+}
+
+template<typename T>
+long TradeStore<T>::Count(const string& _productId, const string& _book, long long _from, long long _to) const
+{
+	long _count = 0;
+	Visit(_productId, _book, _from, _to, [&_count](long _record) { _count++; });
+	return _count;
+}
+
+#endif